@@ -3,10 +3,37 @@
 
 #include "AbilityInputHandler.h"
 #include "GASInputComponent.h"
+#include "GASInputTelemetry.h"
+#include "GASInputRecording.h"
 #include "AbilitySystemComponent.h"
-#include "AbilitySystemBlueprintLibrary.h"
+#include "AbilitySystemGlobals.h"
 #include "EnhancedInputSubsystems.h"
+#include "GASAbilitySystemComponent.h"
+#include "GASAllocationCounter.h"
+#include "GASStats.h"
+#include "GameplayAbility_BaseTriggeredInputActionAbility.h"
 #include "InputMappingContext.h"
+#include "Engine/AssetManager.h"
+#include "Engine/LocalPlayer.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+
+DECLARE_CYCLE_STAT(TEXT("Rebuild Ability Index"), STAT_AbilityInputHandler_RebuildIndex, STATGROUP_AbilityInput);
+DECLARE_CYCLE_STAT(TEXT("Ability Input"), STAT_AbilityInputHandler_AbilityInput, STATGROUP_AbilityInput);
+DECLARE_CYCLE_STAT(TEXT("Event Input"), STAT_AbilityInputHandler_EventInput, STATGROUP_AbilityInput);
+DECLARE_CYCLE_STAT(TEXT("Dynamic Input"), STAT_AbilityInputHandler_DynamicInput, STATGROUP_AbilityInput);
+DECLARE_CYCLE_STAT(TEXT("Triggered Input"), STAT_AbilityInputHandler_TriggeredInput, STATGROUP_AbilityInput);
+DECLARE_CYCLE_STAT(TEXT("Combo Input"), STAT_AbilityInputHandler_ComboInput, STATGROUP_AbilityInput);
+DECLARE_CYCLE_STAT(TEXT("Try Activate"), STAT_AbilityInputHandler_TryActivate, STATGROUP_AbilityInput);
+DECLARE_CYCLE_STAT(TEXT("Retry Buffered Inputs"), STAT_AbilityInputHandler_RetryBuffered, STATGROUP_AbilityInput);
+DECLARE_CYCLE_STAT(TEXT("Bind Input Config"), STAT_AbilityInputHandler_Bind, STATGROUP_AbilityInput);
+DECLARE_CYCLE_STAT(TEXT("Rebind On Controller Change"), STAT_AbilityInputHandler_Rebind, STATGROUP_AbilityInput);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Ability Scans Avoided"), STAT_AbilityInputHandler_ScansAvoided, STATGROUP_AbilityInput);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Inputs Coalesced"), STAT_AbilityInputHandler_Coalesced, STATGROUP_AbilityInput);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Inputs Buffered"), STAT_AbilityInputHandler_Buffered, STATGROUP_AbilityInput);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Buffered Inputs Activated"), STAT_AbilityInputHandler_BufferActivated, STATGROUP_AbilityInput);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Batched Activations"), STAT_AbilityInputHandler_BatchedActivations, STATGROUP_AbilityInput);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Combos Completed"), STAT_AbilityInputHandler_CombosCompleted, STATGROUP_AbilityInput);
 
 
 UAbilityInputHandler::UAbilityInputHandler()
@@ -14,38 +41,228 @@ UAbilityInputHandler::UAbilityInputHandler()
 	// Set this component to be initialized when the game starts, and to be ticked every frame.  You can turn these features
 	// off to improve performance if you don't need them.
 	PrimaryComponentTick.bCanEverTick = true;
+
+	// Only ticks to retry buffered inputs after the ASC's tags changed
+	PrimaryComponentTick.bStartWithTickEnabled = false;
 }
 
 void UAbilityInputHandler::BeginPlay()
 {
 	Super::BeginPlay();
-	if (InputConfig)
+
+	// Looked up once, the input paths never go through the ability system interface
+	AbilitySystem = UAbilitySystemGlobals::GetAbilitySystemComponentFromActor(GetOwner());
+
+	// A lean server never receives input, only the default abilities are needed
+	const bool bServerLeanMode = IsServerLean();
+	if (!bServerLeanMode)
+	{
+		BindInputBufferEvents();
+
+		if (AbilitySystem)
+		{
+			// Only used to report why activations failed
+			AbilityFailedHandle = AbilitySystem->AbilityFailedCallbacks.AddUObject(this, &UAbilityInputHandler::OnAbilityFailed);
+
+			// The ability index is rebuilt when the specs change, other ASCs don't report given and removed abilities
+			AbilitySpecDirtiedHandle = AbilitySystem->AbilitySpecDirtiedCallbacks.AddUObject(this, &UAbilityInputHandler::OnAbilitySpecDirtied);
+			if (UGASAbilitySystemComponent* GASAbilitySystem = Cast<UGASAbilitySystemComponent>(AbilitySystem))
+			{
+				AbilitiesChangedHandle = GASAbilitySystem->OnAbilitiesChanged.AddWeakLambda(this, [this]() { bAbilityIndexDirty = true; });
+				bAbilityChangesReported = true;
+			}
+		}
+	}
+
+	// Hard references are used as they are, soft ones are streamed in first
+	if ((!InputConfig && !SoftInputConfig.IsNull() && !bServerLeanMode) || (!DefaultAbilities && !SoftDefaultAbilities.IsNull())
+		|| (DefaultAbilities && !DefaultAbilities->SoftAbilities.IsEmpty()))
+	{
+		LoadSoftAssets();
+		return;
+	}
+
+	InitializeAbilityInput();
+}
+
+void UAbilityInputHandler::InitializeAbilityInput()
+{
+	const bool bServerLeanMode = IsServerLean();
+	if (InputConfig && !bServerLeanMode)
 	{
 		BindToInputConfig();
+		CacheDynamicInputTagStates();
 		
-		APawn* OwnerPawn = Cast<APawn>(GetOwner());
-		OwnerPawn->ReceiveControllerChangedDelegate.AddDynamic(this, &UAbilityInputHandler::OnControllerChanged);
-
-		if (OwnerPawn->Controller->IsPlayerController())
+		if (APawn* OwnerPawn = Cast<APawn>(GetOwner()))
 		{
-			AddDefaultInputMappings(InputConfig,OwnerPawn->Controller);
+			OwnerPawn->ReceiveControllerChangedDelegate.AddDynamic(this, &UAbilityInputHandler::OnControllerChanged);
+
+			// Pawns spawned without a controller (AI, benchmarks) get their mappings when possessed
+			if (OwnerPawn->Controller && OwnerPawn->Controller->IsPlayerController())
+			{
+				AddDefaultInputMappings(InputConfig,OwnerPawn->Controller);
+			}
 		}
 	}
 	
 	if (DefaultAbilities)
 	{
-		BulkGiveAbilities(DefaultAbilities->Abilities);
+		SyncAbilitiesToAsset(DefaultAbilities);
+	}
+
+	bAbilityInputReady = true;
+	OnAbilityInputReady.Broadcast(this);
+
+	// Nothing left to do on a lean server, SyncAbilitiesToAsset can still be called to change the granted abilities
+	if (bServerLeanMode)
+	{
+		Deactivate();
+	}
+}
+
+bool UAbilityInputHandler::IsServerLean() const
+{
+	return bServerLean && GetNetMode() == NM_DedicatedServer;
+}
+
+void UAbilityInputHandler::LoadSoftAssets()
+{
+	UAssetManager& AssetManager = UAssetManager::Get();
+
+	// A primary default abilities asset is loaded with its bundles, which includes its soft abilities
+	const FPrimaryAssetId DefaultAbilitiesId = DefaultAbilities || SoftDefaultAbilities.IsNull()
+		? FPrimaryAssetId()
+		: AssetManager.GetPrimaryAssetIdForPath(SoftDefaultAbilities.ToSoftObjectPath());
+
+	TArray<FSoftObjectPath> AssetPaths;
+	if (!InputConfig && !SoftInputConfig.IsNull() && !IsServerLean())
+	{
+		AssetPaths.Add(SoftInputConfig.ToSoftObjectPath());
+	}
+	if (!DefaultAbilities && !SoftDefaultAbilities.IsNull() && !DefaultAbilitiesId.IsValid())
+	{
+		AssetPaths.Add(SoftDefaultAbilities.ToSoftObjectPath());
+	}
+
+	FStreamableManager& StreamableManager = UAssetManager::GetStreamableManager();
+	const FStreamableDelegate OnLoaded = FStreamableDelegate::CreateUObject(this, &UAbilityInputHandler::OnSoftAssetsLoaded);
+	if (DefaultAbilitiesId.IsValid())
+	{
+		// Either handle is null when there is nothing left to load
+		TArray<TSharedPtr<FStreamableHandle>> Handles;
+		if (TSharedPtr<FStreamableHandle> PrimaryAssetHandle = AssetManager.LoadPrimaryAsset(DefaultAbilitiesId, DefaultAbilitiesBundles))
+		{
+			Handles.Add(PrimaryAssetHandle);
+		}
+		if (!AssetPaths.IsEmpty())
+		{
+			if (TSharedPtr<FStreamableHandle> AssetsHandle = StreamableManager.RequestAsyncLoad(AssetPaths))
+			{
+				Handles.Add(AssetsHandle);
+			}
+		}
+
+		SoftAssetsLoadHandle = Handles.IsEmpty() ? nullptr : StreamableManager.CreateCombinedHandle(Handles);
+		if (SoftAssetsLoadHandle && !SoftAssetsLoadHandle->HasLoadCompleted())
+		{
+			SoftAssetsLoadHandle->BindCompleteDelegate(OnLoaded);
+			return;
+		}
+	}
+	else if (!AssetPaths.IsEmpty())
+	{
+		SoftAssetsLoadHandle = StreamableManager.RequestAsyncLoad(AssetPaths, OnLoaded);
+		return;
+	}
+
+	OnSoftAssetsLoaded();
+}
+
+void UAbilityInputHandler::OnSoftAssetsLoaded()
+{
+	SoftAssetsLoadHandle.Reset();
+
+	if (!InputConfig && !IsServerLean())
+	{
+		InputConfig = SoftInputConfig.Get();
+	}
+	if (!DefaultAbilities)
+	{
+		DefaultAbilities = SoftDefaultAbilities.Get();
+	}
+
+	// Soft abilities that weren't part of a loaded bundle
+	TArray<FSoftObjectPath> AbilityPaths;
+	if (DefaultAbilities)
+	{
+		for (const FSoftAbilityAssignment& SoftAbility : DefaultAbilities->SoftAbilities)
+		{
+			if (!SoftAbility.Ability.IsNull() && !SoftAbility.Ability.Get())
+			{
+				AbilityPaths.Add(SoftAbility.Ability.ToSoftObjectPath());
+			}
+		}
+	}
+
+	if (AbilityPaths.IsEmpty())
+	{
+		OnSoftAbilitiesLoaded();
+		return;
 	}
+
+	SoftAssetsLoadHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(AbilityPaths,
+		FStreamableDelegate::CreateUObject(this, &UAbilityInputHandler::OnSoftAbilitiesLoaded));
+}
+
+void UAbilityInputHandler::OnSoftAbilitiesLoaded()
+{
+	SoftAssetsLoadHandle.Reset();
+	InitializeAbilityInput();
 }
 
+void UAbilityInputHandler::PreloadDefaultAbilities(const TArray<FPrimaryAssetId>& DefaultAbilitiesIds, const TArray<FName>& Bundles)
+{
+	UAssetManager::Get().LoadPrimaryAssets(DefaultAbilitiesIds, Bundles);
+}
+
+
+void UAbilityInputHandler::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (SoftAssetsLoadHandle)
+	{
+		SoftAssetsLoadHandle->CancelHandle();
+		SoftAssetsLoadHandle.Reset();
+	}
+
+	UnbindFromInputConfig();
+	ClearDynamicInputTagStates();
+	UnbindInputBufferEvents();
+
+	if (AbilitySystem)
+	{
+		AbilitySystem->AbilityFailedCallbacks.Remove(AbilityFailedHandle);
+		AbilitySystem->AbilitySpecDirtiedCallbacks.Remove(AbilitySpecDirtiedHandle);
+		if (UGASAbilitySystemComponent* GASAbilitySystem = Cast<UGASAbilitySystemComponent>(AbilitySystem))
+		{
+			GASAbilitySystem->OnAbilitiesChanged.Remove(AbilitiesChangedHandle);
+		}
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
 
 void UAbilityInputHandler::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
 {
 	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	RetryBufferedInputs();
+	SetComponentTickEnabled(false);
 }
 
 void UAbilityInputHandler::BindToInputConfig()
 {
+	SCOPE_CYCLE_COUNTER(STAT_AbilityInputHandler_Bind);
+
 	// Get the Owner of this Actor Component
 	AActor* Owner = GetOwner();
 	if (!Owner)
@@ -57,13 +274,22 @@ void UAbilityInputHandler::BindToInputConfig()
 	// Try to get the Input Component (Only works if the owner is a Pawn)
 	if (APawn* OwnerPawn = Cast<APawn>(Owner))
 	{
-		AbilitySystem = OwnerPawn->FindComponentByClass<UAbilitySystemComponent>();
+		if (!AbilitySystem)
+		{
+			AbilitySystem = OwnerPawn->FindComponentByClass<UAbilitySystemComponent>();
+		}
 		
-		UGASInputComponent* InputComp = CastChecked<UGASInputComponent>(OwnerPawn->InputComponent);
-		if (InputComp || AbilitySystem)
+		// Only locally controlled pawns have an input component
+		UGASInputComponent* InputComp = Cast<UGASInputComponent>(OwnerPawn->InputComponent);
+		if (InputComp)
 		{
 			UE_LOG(LogTemp, Log, TEXT("GAS Component Found!"));
-			InputComp->BindAbilityActions(InputConfig, this, &UAbilityInputHandler::AbilityInput, &UAbilityInputHandler::EventInput, &UAbilityInputHandler::DynamicInput);
+			UnbindFromInputConfig();
+			InputComp->BindAbilityActions(InputConfig, this, &UAbilityInputHandler::AbilityInput, &UAbilityInputHandler::EventInput, &UAbilityInputHandler::DynamicInput,
+				&InputBindingHandles);
+			BindTriggeredActions(InputComp);
+			BindComboActions(InputComp);
+			BoundInputComponent = InputComp;
 		}
 		else
 		{
@@ -72,175 +298,1061 @@ void UAbilityInputHandler::BindToInputConfig()
 	}
 }
 
-void UAbilityInputHandler::BulkGiveAbilities(TMap<TSubclassOf<UGameplayAbility>, FAbilityAssignerSpec> Abilities)
+void UAbilityInputHandler::BulkGiveAbilities(const TMap<TSubclassOf<UGameplayAbility>, FAbilityAssignerSpec>& Abilities)
 {
+	GrantAbilities(Abilities);
+}
+
+TArray<FGameplayAbilitySpecHandle> UAbilityInputHandler::GrantAbilities(const TMap<TSubclassOf<UGameplayAbility>, FAbilityAssignerSpec>& Abilities)
+{
+	TArray<FGameplayAbilitySpecHandle> GrantedHandles;
+	if (!AbilitySystem || !AbilitySystem->IsOwnerActorAuthoritative())
+	{
+		return GrantedHandles;
+	}
+
+	// One pass over the granted specs rather than a FindAbilitySpecFromClass scan per ability
+	TSet<const UClass*> AlreadyGranted;
+	for (const FGameplayAbilitySpec& Spec : AbilitySystem->GetActivatableAbilities())
+	{
+		if (Spec.Ability)
+		{
+			AlreadyGranted.Add(Spec.Ability->GetClass());
+		}
+	}
+
+	// Every ability is granted before any is activated, so auto-activated abilities find the others already granted
+	TArray<FGameplayAbilitySpecHandle, TInlineAllocator<8>> HandlesToActivate;
 	for (const TPair<TSubclassOf<UGameplayAbility>, FAbilityAssignerSpec>& AbilityPair : Abilities)
 	{
 		TSubclassOf<UGameplayAbility> AbilityClass = AbilityPair.Key;   // Extract the ability class
 		const FAbilityAssignerSpec& AbilitySpec = AbilityPair.Value;    // Extract the ability spec
 
-		if (AbilityClass) // Ensure the class reference is valid
+		if (!AbilityClass || AlreadyGranted.Contains(AbilityClass))
 		{
-			FGameplayAbilitySpec GameplayAbilitySpec(AbilityClass, AbilitySpec.Level, AbilitySpec.inputID);
-		
-			if (AbilitySpec.AutoActivate)
-			{
-				if (AbilitySpec.ActivateOnce)
-				{
-					AbilitySystem->GiveAbilityAndActivateOnce(GameplayAbilitySpec);
-					UE_LOG(LogTemp, Log, TEXT("Gave and activated ability once: %s"), *AbilityClass->GetName());
-				}
-				else
-				{
-					AbilitySystem->GiveAbility(GameplayAbilitySpec);
-					AbilitySystem->TryActivateAbilityByClass(AbilityClass);
-					UE_LOG(LogTemp, Log, TEXT("Gave and activated ability: %s"), *AbilityClass->GetName());
-				}
-			}
-			else
+			continue;
+		}
+		AlreadyGranted.Add(AbilityClass);
+
+		FGameplayAbilitySpec GameplayAbilitySpec(AbilityClass, AbilitySpec.Level, AbilitySpec.inputID);
+
+		// Same as GiveAbilityAndActivateOnce
+		if (AbilitySpec.AutoActivate && AbilitySpec.ActivateOnce)
+		{
+			GameplayAbilitySpec.RemoveAfterActivation = true;
+		}
+
+		const FGameplayAbilitySpecHandle Handle = AbilitySystem->GiveAbility(GameplayAbilitySpec);
+		GrantedHandles.Add(Handle);
+		if (AbilitySpec.AutoActivate)
+		{
+			HandlesToActivate.Add(Handle);
+		}
+
+		UE_LOG(LogTemp, Log, TEXT("Gave ability: %s"), *AbilityClass->GetName());
+	}
+
+	for (const FGameplayAbilitySpecHandle& Handle : HandlesToActivate)
+	{
+		const FGameplayAbilitySpec* Spec = AbilitySystem->FindAbilitySpecFromHandle(Handle);
+		if (!Spec || !Spec->Ability)
+		{
+			continue;
+		}
+
+		// Read before activating, the spec is gone once an activate-once ability has run
+		const bool bActivateOnce = Spec->RemoveAfterActivation;
+		const TSubclassOf<UGameplayAbility> AbilityClass = Spec->Ability->GetClass();
+		if (AbilitySystem->TryActivateAbility(Handle))
+		{
+			if (bActivateOnce)
 			{
-				AbilitySystem->GiveAbility(GameplayAbilitySpec);
-				UE_LOG(LogTemp, Log, TEXT("Gave ability: %s"), *AbilityClass->GetName());
+				ActivatedOnceAbilities.Add(AbilityClass);
 			}
 		}
+		else if (bActivateOnce)
+		{
+			// Same as GiveAbilityAndActivateOnce, an activate-once ability that couldn't run isn't left granted
+			AbilitySystem->ClearAbility(Handle);
+			GrantedHandles.Remove(Handle);
+		}
 	}
+
+	bAbilityIndexDirty = true;
+	return GrantedHandles;
 }
 
-void UAbilityInputHandler::AddDefaultInputMappings(UGASInputConfig* InInputConfig, AController* Controller)
+void UAbilityInputHandler::GatherDefaultAbilities(const UDefaultAbilities* Asset, TMap<TSubclassOf<UGameplayAbility>, FAbilityAssignerSpec>& OutAbilities)
 {
-	if (!InInputConfig)
+	if (!Asset)
 	{
-		UE_LOG(LogTemp, Warning, TEXT("InInputConfig is null!"));
 		return;
 	}
-	
-	if (APlayerController* PlayerController = Cast<APlayerController>(Controller))
+
+	OutAbilities.Append(Asset->Abilities);
+	for (const FSoftAbilityAssignment& SoftAbility : Asset->SoftAbilities)
 	{
-		// Get the Enhanced Input Subsystem
-		if (UEnhancedInputLocalPlayerSubsystem* InputSubsystem = PlayerController->GetLocalPlayer()->GetSubsystem<UEnhancedInputLocalPlayerSubsystem>())
+		if (UClass* AbilityClass = SoftAbility.Ability.Get())
 		{
-			// Loop through the DefaultInputMapping TMap
-			for (const TPair<UInputMappingContext*, FICMPayload>& MappingPair : InInputConfig->DefaultInputMapping)
-			{
-				UInputMappingContext* MappingContext = MappingPair.Key;
-				const FICMPayload& Payload = MappingPair.Value;
+			OutAbilities.Add(AbilityClass, SoftAbility.Spec);
+		}
+	}
+}
+
+void UAbilityInputHandler::SyncAbilitiesToAsset(UDefaultAbilities* Asset)
+{
+	if (!AbilitySystem || !AbilitySystem->IsOwnerActorAuthoritative())
+	{
+		return;
+	}
 
-				// Add input context with the appropriate priority
-				InputSubsystem->AddMappingContext(MappingContext, Payload.Priority, Payload.ContextOptions);
+	TMap<TSubclassOf<UGameplayAbility>, FAbilityAssignerSpec> WantedAbilities;
+	GatherDefaultAbilities(Asset, WantedAbilities);
 
-				// Log the addition of the input mapping context with its priority
-				UE_LOG(LogTemp, Log, TEXT("Added input mapping context: %s with priority %d"), *MappingContext->GetName(), Payload.Priority);
-			}
+	// Clear what the asset no longer lists and update what it still does, the rest is granted below
+	for (auto It = GrantedDefaultAbilities.CreateIterator(); It; ++It)
+	{
+		const FAbilityAssignerSpec* WantedSpec = WantedAbilities.Find(It.Key());
+		FGameplayAbilitySpec* Spec = AbilitySystem->FindAbilitySpecFromHandle(It.Value());
+		if (!Spec)
+		{
+			// Removed by something else, granted again below if still wanted
+			It.RemoveCurrent();
+			continue;
 		}
-		else
+
+		if (!WantedSpec)
 		{
-			UE_LOG(LogTemp, Warning, TEXT("Enhanced Input Subsystem not found on the Player Controller!"));
+			AbilitySystem->ClearAbility(It.Value());
+			It.RemoveCurrent();
+			continue;
 		}
+
+		if (Spec->Level != WantedSpec->Level || Spec->InputID != WantedSpec->inputID)
+		{
+			Spec->Level = WantedSpec->Level;
+			Spec->InputID = WantedSpec->inputID;
+			AbilitySystem->MarkAbilitySpecDirty(*Spec);
+		}
+
+		WantedAbilities.Remove(It.Key());
 	}
-	else
+
+	// Activate-once abilities that already ran are done, unless the asset stopped listing them as such. One still running is
+	// tracked above and was kept
+	for (auto It = ActivatedOnceAbilities.CreateIterator(); It; ++It)
+	{
+		const FAbilityAssignerSpec* WantedSpec = WantedAbilities.Find(*It);
+		if (WantedSpec && WantedSpec->AutoActivate && WantedSpec->ActivateOnce)
+		{
+			WantedAbilities.Remove(*It);
+		}
+		else if (!GrantedDefaultAbilities.Contains(*It))
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	const TArray<FGameplayAbilitySpecHandle> GrantedHandles = GrantAbilities(WantedAbilities);
+
+	// Abilities the ASC already had from elsewhere are skipped and stay untracked
+	for (const FGameplayAbilitySpecHandle& Handle : GrantedHandles)
 	{
-		UE_LOG(LogTemp, Warning, TEXT("Not a player controller!"));
+		if (const FGameplayAbilitySpec* Spec = AbilitySystem->FindAbilitySpecFromHandle(Handle); Spec && Spec->Ability)
+		{
+			GrantedDefaultAbilities.Add(Spec->Ability->GetClass(), Handle);
+		}
 	}
+
+	DefaultAbilities = Asset;
+	bAbilityIndexDirty = true;
 }
 
-void UAbilityInputHandler::RemoveDefaultInputMappings(UGASInputConfig* InInputConfig, AController* Controller)
+void UAbilityInputHandler::UpdateAbilityIndex()
 {
-	if (!InInputConfig)
+	const TArray<FGameplayAbilitySpec>& AbilitySpecs = AbilitySystem->GetActivatableAbilities();
+	if (!bAbilityIndexDirty && (bAbilityChangesReported || !HaveAbilityHandlesChanged(AbilitySpecs)))
 	{
-		UE_LOG(LogTemp, Warning, TEXT("InInputConfig is null!"));
 		return;
 	}
-	
-	if (APlayerController* PlayerController = Cast<APlayerController>(Controller))
+
+	SCOPE_CYCLE_COUNTER(STAT_AbilityInputHandler_RebuildIndex);
+
+	AbilitySpecsByInputTag.Reset();
+	IndexedAbilityHandles.Reset();
+	for (const FGameplayAbilitySpec& Spec : AbilitySpecs)
 	{
-		// Get the Enhanced Input Subsystem
-		if (UEnhancedInputLocalPlayerSubsystem* InputSubsystem = PlayerController->GetLocalPlayer()->GetSubsystem<UEnhancedInputLocalPlayerSubsystem>())
-		{
-			// Loop through the DefaultInputMapping TMap
-			for (const TPair<UInputMappingContext*, FICMPayload>& MappingPair : InInputConfig->DefaultInputMapping)
-			{
-				UInputMappingContext* MappingContext = MappingPair.Key;
-				const FICMPayload& Payload = MappingPair.Value;
+		IndexedAbilityHandles.Add(Spec.Handle);
+	}
+	bAbilityIndexDirty = false;
 
-				// Add input context with the appropriate priority
-				InputSubsystem->RemoveMappingContext(MappingContext, Payload.ContextOptions);
+	if (!InputConfig)
+	{
+		return;
+	}
 
-				// Log the addition of the input mapping context with its priority
-				UE_LOG(LogTemp, Log, TEXT("Removed input mapping context: %s"), *MappingContext->GetName());
-			}
+	// Only the tags that can reach AbilityInput are indexed
+	auto IndexInputTag = [this, &AbilitySpecs](const FGameplayTag& InputTag, GASInputEventType EventType)
+	{
+		if (EventType != GASInputEventType::GameplayAbility && EventType != GASInputEventType::GameplayDynamic)
+		{
+			return;
 		}
-		else
+		if (!InputTag.IsValid() || AbilitySpecsByInputTag.Contains(InputTag))
+		{
+			return;
+		}
+
+		TArray<FGameplayAbilitySpecHandle>& Handles = AbilitySpecsByInputTag.Add(InputTag);
+		for (const FGameplayAbilitySpec& Spec : AbilitySpecs)
 		{
-			UE_LOG(LogTemp, Warning, TEXT("Enhanced Input Subsystem not found on the Player Controller!"));
+			if (DoesSpecMatchInputTag(Spec, InputTag))
+			{
+				Handles.Add(Spec.Handle);
+			}
 		}
+	};
+
+	for (const FGASInputBinding& Binding : InputConfig->GetCompiledBindings())
+	{
+		IndexInputTag(Binding.InputTag, Binding.EventType);
 	}
-	else
+	for (const FGASInputCombo& Combo : InputConfig->Combos)
 	{
-		UE_LOG(LogTemp, Warning, TEXT("Not a player controller!"));
+		IndexInputTag(Combo.InputTag, Combo.EventType);
 	}
 }
 
-void UAbilityInputHandler::AbilityInput(FGameplayTag InInputTag)
+bool UAbilityInputHandler::HaveAbilityHandlesChanged(const TArray<FGameplayAbilitySpec>& AbilitySpecs) const
 {
-	if (AbilitySystem)
+	// Abilities given and removed between two inputs can keep the count the same, compare the handles
+	if (AbilitySpecs.Num() != IndexedAbilityHandles.Num())
 	{
-		FGameplayTagContainer InputTags;
-		InputTags.AddTag(InInputTag);
-		
-		// Attempt to activate ability
-		bool bActivated = AbilitySystem->TryActivateAbilitiesByTag(InputTags, false);
-		
-		//UE_LOG(LogTemp, Warning, TEXT("Trying ability with tag: %s | Activation Success: %s"), 
-		//	*InInputTag.ToString(), 
-		//	bActivated ? TEXT("True") : TEXT("False"));
+		return true;
 	}
-	else
+
+	for (int32 Index = 0; Index < AbilitySpecs.Num(); ++Index)
 	{
-		UE_LOG(LogTemp, Error, TEXT("AbilityInput failed: AbilitySystem is nullptr!"));
+		if (AbilitySpecs[Index].Handle != IndexedAbilityHandles[Index])
+		{
+			return true;
+		}
 	}
+	return false;
 }
 
-void UAbilityInputHandler::EventInput(FGameplayTag InInputTag)
+bool UAbilityInputHandler::DoesSpecMatchInputTag(const FGameplayAbilitySpec& Spec, const FGameplayTag& InputTag)
 {
-	if (AbilitySystem)
+	// Same matching as TryActivateAbilitiesByTag: the ability's asset tags or the spec's dynamic tags contain the input tag
+	return Spec.Ability && (Spec.Ability->GetAssetTags().HasTag(InputTag) || Spec.GetDynamicSpecSourceTags().HasTag(InputTag));
+}
+
+void UAbilityInputHandler::OnAbilitySpecDirtied(const FGameplayAbilitySpec& Spec)
+{
+	// Specs are dirtied by every activation too, only rebuild if a dynamic tag change moved the spec in or out of the index
+	if (bAbilityIndexDirty)
 	{
-		FGameplayEventData Data;
-		UAbilitySystemBlueprintLibrary::SendGameplayEventToActor(GetOwner(), InInputTag, Data);
-		
-		//UE_LOG(LogTemp, Warning, TEXT("Performing Gameplay Event with tag: %s"), 
-		//	*InInputTag.ToString());
+		return;
 	}
-	else
+
+	for (const TPair<FGameplayTag, TArray<FGameplayAbilitySpecHandle>>& IndexEntry : AbilitySpecsByInputTag)
 	{
-		UE_LOG(LogTemp, Error, TEXT("EventInput failed: AbilitySystem is nullptr!"));
+		if (DoesSpecMatchInputTag(Spec, IndexEntry.Key) != IndexEntry.Value.Contains(Spec.Handle))
+		{
+			bAbilityIndexDirty = true;
+			return;
+		}
 	}
 }
 
-void UAbilityInputHandler::DynamicInput(FGameplayTag InInputTag)
+UEnhancedInputLocalPlayerSubsystem* UAbilityInputHandler::GetInputSubsystem(AController* Controller)
+{
+	const APlayerController* PlayerController = Cast<APlayerController>(Controller);
+	const ULocalPlayer* LocalPlayer = PlayerController ? PlayerController->GetLocalPlayer() : nullptr;
+	return LocalPlayer ? LocalPlayer->GetSubsystem<UEnhancedInputLocalPlayerSubsystem>() : nullptr;
+}
+
+void UAbilityInputHandler::AddDefaultInputMappings(UGASInputConfig* InInputConfig, AController* Controller)
 {
-	if (AbilitySystem->HasMatchingGameplayTag(InInputTag))
+	if (!InInputConfig)
 	{
-		EventInput(InInputTag);
+		UE_LOG(LogTemp, Warning, TEXT("InInputConfig is null!"));
+		return;
 	}
-	else
+	
+	// Get the Enhanced Input Subsystem
+	UEnhancedInputLocalPlayerSubsystem* InputSubsystem = GetInputSubsystem(Controller);
+	if (!InputSubsystem)
 	{
-		AbilityInput(InInputTag);
+		UE_LOG(LogTemp, Warning, TEXT("Enhanced Input Subsystem not found on the Controller!"));
+		return;
+	}
+
+	// Every change is deferred and the control mappings are rebuilt once, immediately if any context asked for it
+	FModifyContextOptions RebuildOptions;
+	bool bChanged = false;
+
+	// Loop through the DefaultInputMapping TMap
+	for (const TPair<UInputMappingContext*, FICMPayload>& MappingPair : InInputConfig->DefaultInputMapping)
+	{
+		UInputMappingContext* MappingContext = MappingPair.Key;
+		const FICMPayload& Payload = MappingPair.Value;
+
+		if (!MappingContext || InputSubsystem->HasMappingContext(MappingContext))
+		{
+			continue;
+		}
+
+		FModifyContextOptions DeferredOptions = Payload.ContextOptions;
+		DeferredOptions.bForceImmediately = false;
+		RebuildOptions.bForceImmediately |= Payload.ContextOptions.bForceImmediately;
+		RebuildOptions.bIgnoreAllPressedKeysUntilRelease |= Payload.ContextOptions.bIgnoreAllPressedKeysUntilRelease;
+
+		// Add input context with the appropriate priority
+		InputSubsystem->AddMappingContext(MappingContext, Payload.Priority, DeferredOptions);
+		AddedMappingContexts.Add(MappingContext);
+		bChanged = true;
+
+		// Log the addition of the input mapping context with its priority
+		UE_LOG(LogTemp, Log, TEXT("Added input mapping context: %s with priority %d"), *MappingContext->GetName(), Payload.Priority);
+	}
+
+	if (bChanged)
+	{
+		InputSubsystem->RequestRebuildControlMappings(RebuildOptions);
 	}
 }
 
-void UAbilityInputHandler::OnControllerChanged(APawn* Pawn, AController* OldController, AController* NewController)
+void UAbilityInputHandler::RemoveDefaultInputMappings(UGASInputConfig* InInputConfig, AController* Controller)
 {
-	//Remove Input Context Mappings provided by the Input Config from the old controller.
-	RemoveDefaultInputMappings(InputConfig,OldController);
-
-	//Clear input binds on the input component and rebind to input config... Will this work?
-	if (UEnhancedInputComponent* FoundInputComponent = Cast<UEnhancedInputComponent>(Pawn->InputComponent))
+	if (!InInputConfig)
 	{
-		FoundInputComponent->ClearActionBindings();
-		BindToInputConfig();
+		UE_LOG(LogTemp, Warning, TEXT("InInputConfig is null!"));
+		return;
 	}
 	
-	//Add input Context Mappings provided by the Input Config to the new controller.
-	AddDefaultInputMappings(InputConfig, NewController);
-	
-}
+	// Get the Enhanced Input Subsystem
+	UEnhancedInputLocalPlayerSubsystem* InputSubsystem = GetInputSubsystem(Controller);
+	if (!InputSubsystem)
+	{
+		AddedMappingContexts.Reset();
+		return;
+	}
+
+	FModifyContextOptions RebuildOptions;
+	bool bChanged = false;
+
+	// Only the contexts this handler added
+	for (const TPair<UInputMappingContext*, FICMPayload>& MappingPair : InInputConfig->DefaultInputMapping)
+	{
+		UInputMappingContext* MappingContext = MappingPair.Key;
+		const FICMPayload& Payload = MappingPair.Value;
+
+		if (!MappingContext || !AddedMappingContexts.Contains(MappingContext))
+		{
+			continue;
+		}
+
+		FModifyContextOptions DeferredOptions = Payload.ContextOptions;
+		DeferredOptions.bForceImmediately = false;
+		RebuildOptions.bForceImmediately |= Payload.ContextOptions.bForceImmediately;
+		RebuildOptions.bIgnoreAllPressedKeysUntilRelease |= Payload.ContextOptions.bIgnoreAllPressedKeysUntilRelease;
+
+		InputSubsystem->RemoveMappingContext(MappingContext, DeferredOptions);
+		bChanged = true;
+
+		UE_LOG(LogTemp, Log, TEXT("Removed input mapping context: %s"), *MappingContext->GetName());
+	}
+
+	AddedMappingContexts.Reset();
+
+	if (bChanged)
+	{
+		InputSubsystem->RequestRebuildControlMappings(RebuildOptions);
+	}
+}
+
+void UAbilityInputHandler::AbilityInput(FGameplayTag InInputTag, ETriggerEvent TriggerEvent)
+{
+	SCOPE_CYCLE_COUNTER(STAT_AbilityInputHandler_AbilityInput);
+#if !UE_BUILD_SHIPPING
+	if (GASInputRecorder::IsRecording())
+	{
+		GASInputRecorder::RecordTagInput(*this, InInputTag, TriggerEvent, GASInputEventType::GameplayAbility);
+	}
+#endif
+	DispatchAbilityInput(InInputTag, TriggerEvent, GASInputEventType::GameplayAbility, FPlatformTime::Cycles64());
+}
+
+void UAbilityInputHandler::DispatchAbilityInput(const FGameplayTag& InInputTag, ETriggerEvent TriggerEvent, GASInputEventType EventType, uint64 StartCycles)
+{
+	FGASInputSample Sample;
+	Sample.InputTag = InInputTag;
+	Sample.EventType = EventType;
+	Sample.TriggerEvent = TriggerEvent;
+
+	if (!AbilitySystem)
+	{
+		UE_LOG(LogTemp, Error, TEXT("AbilityInput failed: AbilitySystem is nullptr!"));
+		Sample.Result = EGASInputResult::NoAbilitySystem;
+		GASInputTelemetry::Record(Sample);
+		return;
+	}
+
+	// Triggered bindings fire every frame while held, and several actions may share a tag
+	if (bCoalesceInputPerFrame)
+	{
+		uint64& LastFrame = LastAbilityInputFrames.FindOrAdd(InInputTag, MAX_uint64);
+		if (LastFrame == GFrameCounter)
+		{
+			INC_DWORD_STAT(STAT_AbilityInputHandler_Coalesced);
+			Sample.Result = EGASInputResult::Coalesced;
+			GASInputTelemetry::Record(Sample);
+			return;
+		}
+		LastFrame = GFrameCounter;
+	}
+
+	// Already waiting for whatever blocked it to clear, extend the window rather than retrying blindly
+	const double Now = GetWorld()->GetTimeSeconds();
+	const double ExpireTime = Now + InputBufferWindow;
+	for (int32 Index = 0; Index < BufferedAbilityInputs.Num(); ++Index)
+	{
+		FBufferedAbilityInput& BufferedInput = BufferedAbilityInputs[Index];
+		if (BufferedInput.InputTag != InInputTag)
+		{
+			continue;
+		}
+
+		// Expired without a retry, e.g. a cost or cooldown failure no tag change clears: this press tries again
+		if (BufferedInput.ExpireTime < Now)
+		{
+			FGASInputSample ExpiredSample;
+			ExpiredSample.InputTag = BufferedInput.InputTag;
+			ExpiredSample.EventType = BufferedInput.EventType;
+			ExpiredSample.TriggerEvent = BufferedInput.TriggerEvent;
+			ExpiredSample.Result = EGASInputResult::Expired;
+			GASInputTelemetry::Record(ExpiredSample);
+
+			BufferedAbilityInputs.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+			break;
+		}
+
+		BufferedInput.ExpireTime = ExpireTime;
+		INC_DWORD_STAT(STAT_AbilityInputHandler_Coalesced);
+		Sample.Result = EGASInputResult::BufferExtended;
+		GASInputTelemetry::Record(Sample);
+		return;
+	}
+
+	const bool bActivated = TryActivateAbilityInput(InInputTag);
+	if (bActivated)
+	{
+		Sample.Result = EGASInputResult::Activated;
+		Sample.LatencySeconds = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles);
+	}
+	else
+	{
+		Sample.FailureReason = LastActivationFailureTags.First();
+		Sample.Result = InputBufferWindow > 0.f ? EGASInputResult::Buffered : EGASInputResult::Failed;
+		if (InputBufferWindow > 0.f)
+		{
+			BufferedAbilityInputs.Add({ InInputTag, LastActivationFailureTags, ExpireTime, StartCycles, EventType, TriggerEvent });
+			INC_DWORD_STAT(STAT_AbilityInputHandler_Buffered);
+		}
+	}
+	GASInputTelemetry::Record(Sample);
+	
+	//UE_LOG(LogTemp, Warning, TEXT("Trying ability with tag: %s | Activation Success: %s"), 
+	//	*InInputTag.ToString(), 
+	//	bActivated ? TEXT("True") : TEXT("False"));
+}
+
+bool UAbilityInputHandler::TryActivateAbilityInput(const FGameplayTag& InInputTag)
+{
+	SCOPE_CYCLE_COUNTER(STAT_AbilityInputHandler_TryActivate);
+
+	UpdateAbilityIndex();
+	LastActivationFailureTags.Reset();
+
+	bool bActivated = false;
+	if (const TArray<FGameplayAbilitySpecHandle>* Handles = AbilitySpecsByInputTag.Find(InInputTag))
+	{
+		// Activate the matching specs directly instead of scanning every ability for the tag
+		for (const FGameplayAbilitySpecHandle& Handle : *Handles)
+		{
+			bActivated |= TryActivateAbilityBatched(Handle);
+		}
+		++AvoidedAbilityScans;
+		INC_DWORD_STAT(STAT_AbilityInputHandler_ScansAvoided);
+	}
+	else
+	{
+		ScratchInputTags.Reset();
+		ScratchInputTags.AddTagFast(InInputTag);
+		
+		// Same as TryActivateAbilitiesByTag, one spec at a time so each activation gets its own batch. The handles are copied
+		// first, an activation may give or remove specs and reallocate the spec list, or dispatch input and reuse the scratch
+		ScratchMatchingSpecs.Reset();
+		AbilitySystem->GetActivatableGameplayAbilitySpecsByAllMatchingTags(ScratchInputTags, ScratchMatchingSpecs, false);
+
+		TArray<FGameplayAbilitySpecHandle, TInlineAllocator<4>> MatchingHandles;
+		for (const FGameplayAbilitySpec* Spec : ScratchMatchingSpecs)
+		{
+			MatchingHandles.Add(Spec->Handle);
+		}
+		ScratchMatchingSpecs.Reset();
+		for (const FGameplayAbilitySpecHandle& Handle : MatchingHandles)
+		{
+			bActivated |= TryActivateAbilityBatched(Handle);
+		}
+	}
+
+	return bActivated;
+}
+
+bool UAbilityInputHandler::TryActivateAbilityBatched(const FGameplayAbilitySpecHandle& Handle)
+{
+	// Does nothing unless the ASC batches, the batch is sent when the scope ends if the ability activated
+	FScopedServerAbilityRPCBatcher RPCBatcher(AbilitySystem, Handle);
+	const bool bActivated = AbilitySystem->TryActivateAbility(Handle, false);
+	if (bActivated && AbilitySystem->ShouldDoServerAbilityRPCBatch())
+	{
+		INC_DWORD_STAT(STAT_AbilityInputHandler_BatchedActivations);
+	}
+	return bActivated;
+}
+
+void UAbilityInputHandler::OnAbilityFailed(const UGameplayAbility* Ability, const FGameplayTagContainer& FailureTags)
+{
+	LastActivationFailureTags.AppendTags(FailureTags);
+}
+
+void UAbilityInputHandler::ClearInputBuffer()
+{
+	BufferedAbilityInputs.Reset();
+}
+
+void UAbilityInputHandler::BindInputBufferEvents()
+{
+	if (!AbilitySystem || InputBufferWindow <= 0.f)
+	{
+		return;
+	}
+
+	// Cooldowns and blocking states are tags going away, and an active ability ending frees its own activation
+	AnyTagChangedHandle = AbilitySystem->RegisterGenericGameplayTagEvent().AddUObject(this, &UAbilityInputHandler::OnAnyTagChanged);
+	AbilityEndedHandle = AbilitySystem->OnAbilityEnded.AddUObject(this, &UAbilityInputHandler::OnAbilityEnded);
+}
+
+void UAbilityInputHandler::UnbindInputBufferEvents()
+{
+	if (AbilitySystem)
+	{
+		AbilitySystem->RegisterGenericGameplayTagEvent().Remove(AnyTagChangedHandle);
+		AbilitySystem->OnAbilityEnded.Remove(AbilityEndedHandle);
+	}
+
+	AnyTagChangedHandle.Reset();
+	AbilityEndedHandle.Reset();
+	BufferedAbilityInputs.Reset();
+}
+
+void UAbilityInputHandler::OnAnyTagChanged(const FGameplayTag Tag, int32 NewCount)
+{
+	// A blocking or cooldown tag going away, or a missing tag being added. Inputs that only failed on costs or other
+	// generic reasons wait for an ability to end, or for the next press once expired
+	for (const FBufferedAbilityInput& BufferedInput : BufferedAbilityInputs)
+	{
+		if (BufferedInput.FailureTags.HasTagExact(Tag))
+		{
+			RequestBufferedInputRetry();
+			return;
+		}
+	}
+}
+
+void UAbilityInputHandler::OnAbilityEnded(const FAbilityEndedData& EndedData)
+{
+	RequestBufferedInputRetry();
+}
+
+void UAbilityInputHandler::RequestBufferedInputRetry()
+{
+	// Deferred to the next tick, the events fire in the middle of effect and ability processing
+	if (!BufferedAbilityInputs.IsEmpty())
+	{
+		SetComponentTickEnabled(true);
+	}
+}
+
+void UAbilityInputHandler::RetryBufferedInputs()
+{
+	SCOPE_CYCLE_COUNTER(STAT_AbilityInputHandler_RetryBuffered);
+
+	if (!AbilitySystem)
+	{
+		BufferedAbilityInputs.Reset();
+		return;
+	}
+
+	const double Now = GetWorld()->GetTimeSeconds();
+	for (int32 Index = BufferedAbilityInputs.Num() - 1; Index >= 0; --Index)
+	{
+		// Copied, activating may buffer or clear inputs
+		const FBufferedAbilityInput BufferedInput = BufferedAbilityInputs[Index];
+		const bool bExpired = BufferedInput.ExpireTime < Now;
+		const bool bActivated = !bExpired && TryActivateAbilityInput(BufferedInput.InputTag);
+		if (bActivated)
+		{
+			INC_DWORD_STAT(STAT_AbilityInputHandler_BufferActivated);
+		}
+
+		if (bExpired || bActivated)
+		{
+			FGASInputSample Sample;
+			Sample.InputTag = BufferedInput.InputTag;
+			Sample.EventType = BufferedInput.EventType;
+			Sample.TriggerEvent = BufferedInput.TriggerEvent;
+			Sample.Result = bActivated ? EGASInputResult::Activated : EGASInputResult::Expired;
+			Sample.LatencySeconds = bActivated ? FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - BufferedInput.PressCycles) : 0.0;
+			GASInputTelemetry::Record(Sample);
+		}
+
+		if (!BufferedAbilityInputs.IsValidIndex(Index))
+		{
+			continue;
+		}
+
+		if (bExpired || bActivated)
+		{
+			BufferedAbilityInputs.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+		}
+		else
+		{
+			// It may now fail on something else, e.g. a cooldown once the blocking tag went away
+			BufferedAbilityInputs[Index].FailureTags = LastActivationFailureTags;
+		}
+	}
+}
+
+void UAbilityInputHandler::EventInput(FGameplayTag InInputTag, ETriggerEvent TriggerEvent)
+{
+	SCOPE_CYCLE_COUNTER(STAT_AbilityInputHandler_EventInput);
+#if !UE_BUILD_SHIPPING
+	if (GASInputRecorder::IsRecording())
+	{
+		GASInputRecorder::RecordTagInput(*this, InInputTag, TriggerEvent, GASInputEventType::GameplayEvent);
+	}
+#endif
+	DispatchEventInput(InInputTag, TriggerEvent, GASInputEventType::GameplayEvent, FPlatformTime::Cycles64());
+}
+
+void UAbilityInputHandler::DispatchEventInput(const FGameplayTag& InInputTag, ETriggerEvent TriggerEvent, GASInputEventType EventType, uint64 StartCycles)
+{
+	FGASInputSample Sample;
+	Sample.InputTag = InInputTag;
+	Sample.EventType = EventType;
+	Sample.TriggerEvent = TriggerEvent;
+
+	if (AbilitySystem)
+	{
+		// Same as UAbilitySystemBlueprintLibrary::SendGameplayEventToActor, minus the ASC lookup through the interface
+		FScopedPredictionWindow NewScopedWindow(AbilitySystem, true);
+		FGameplayEventData Data;
+		AbilitySystem->HandleGameplayEvent(InInputTag, &Data);
+
+		Sample.Result = EGASInputResult::EventSent;
+		Sample.LatencySeconds = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles);
+		
+		//UE_LOG(LogTemp, Warning, TEXT("Performing Gameplay Event with tag: %s"), 
+		//	*InInputTag.ToString());
+	}
+	else
+	{
+		UE_LOG(LogTemp, Error, TEXT("EventInput failed: AbilitySystem is nullptr!"));
+		Sample.Result = EGASInputResult::NoAbilitySystem;
+	}
+
+	GASInputTelemetry::Record(Sample);
+}
+
+void UAbilityInputHandler::DynamicInput(FGameplayTag InInputTag, ETriggerEvent TriggerEvent)
+{
+	SCOPE_CYCLE_COUNTER(STAT_AbilityInputHandler_DynamicInput);
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+#if !UE_BUILD_SHIPPING
+	if (GASInputRecorder::IsRecording())
+	{
+		GASInputRecorder::RecordTagInput(*this, InInputTag, TriggerEvent, GASInputEventType::GameplayDynamic);
+	}
+#endif
+
+	// Tag states are cached for every dynamic tag of the config, only query the ASC for other tags
+	const bool* CachedHasTag = DynamicInputTagStates.Find(InInputTag);
+	const bool bHasTag = CachedHasTag ? *CachedHasTag : AbilitySystem && AbilitySystem->HasMatchingGameplayTag(InInputTag);
+
+	if (bHasTag)
+	{
+		DispatchEventInput(InInputTag, TriggerEvent, GASInputEventType::GameplayDynamic, StartCycles);
+	}
+	else
+	{
+		DispatchAbilityInput(InInputTag, TriggerEvent, GASInputEventType::GameplayDynamic, StartCycles);
+	}
+}
+
+void UAbilityInputHandler::CacheDynamicInputTagStates()
+{
+	ClearDynamicInputTagStates();
+
+	if (!AbilitySystem || !InputConfig)
+	{
+		return;
+	}
+
+	for (const FGASInputBinding& Binding : InputConfig->GetCompiledBindings())
+	{
+		if (Binding.EventType != GASInputEventType::GameplayDynamic || !Binding.InputTag.IsValid() || DynamicInputTagStates.Contains(Binding.InputTag))
+		{
+			continue;
+		}
+
+		DynamicInputTagStates.Add(Binding.InputTag, AbilitySystem->HasMatchingGameplayTag(Binding.InputTag));
+
+		const FDelegateHandle Handle = AbilitySystem->RegisterGameplayTagEvent(Binding.InputTag, EGameplayTagEventType::NewOrRemoved)
+			.AddUObject(this, &UAbilityInputHandler::OnDynamicInputTagChanged);
+		DynamicInputTagHandles.Emplace(Binding.InputTag, Handle);
+	}
+}
+
+void UAbilityInputHandler::ClearDynamicInputTagStates()
+{
+	if (AbilitySystem)
+	{
+		for (const TPair<FGameplayTag, FDelegateHandle>& TagHandle : DynamicInputTagHandles)
+		{
+			AbilitySystem->UnregisterGameplayTagEvent(TagHandle.Value, TagHandle.Key, EGameplayTagEventType::NewOrRemoved);
+		}
+	}
+
+	DynamicInputTagHandles.Reset();
+	DynamicInputTagStates.Reset();
+}
+
+void UAbilityInputHandler::OnDynamicInputTagChanged(const FGameplayTag Tag, int32 NewCount)
+{
+	if (bool* HasTag = DynamicInputTagStates.Find(Tag))
+	{
+		*HasTag = NewCount > 0;
+	}
+}
+
+void UAbilityInputHandler::BindTriggeredActions(UEnhancedInputComponent* InputComp)
+{
+	TriggeredActionsByTag.Reset();
+
+	// Every trigger of every action shares one handler, the action is read back from the instance
+	TSet<const UInputAction*> BoundActions;
+	for (const FGASInputBinding& Binding : InputConfig->GetCompiledBindings())
+	{
+		if (Binding.TriggerEvent != ETriggerEvent::Triggered || !Binding.InputTag.IsValid())
+		{
+			continue;
+		}
+
+		TriggeredActionsByTag.FindOrAdd(Binding.InputTag).AddUnique(Binding.InputAction);
+
+		bool bAlreadyBound = false;
+		BoundActions.Add(Binding.InputAction, &bAlreadyBound);
+		if (!bAlreadyBound)
+		{
+			InputBindingHandles.Add(InputComp->BindAction(Binding.InputAction, ETriggerEvent::Triggered, this, &UAbilityInputHandler::OnTriggeredInput).GetHandle());
+			TriggeredAbilitiesByAction.FindOrAdd(Binding.InputAction);
+		}
+	}
+}
+
+bool UAbilityInputHandler::RegisterTriggeredAbility(UGameplayAbility_BaseTriggeredInputActionAbility* Ability)
+{
+	bool bRegistered = false;
+	for (const FGameplayTag& AbilityTag : Ability->GetAssetTags())
+	{
+		const TArray<TObjectPtr<const UInputAction>>* Actions = TriggeredActionsByTag.Find(AbilityTag);
+		if (!Actions)
+		{
+			continue;
+		}
+
+		for (const UInputAction* Action : *Actions)
+		{
+			TriggeredAbilitiesByAction.FindOrAdd(Action).AddUnique(Ability);
+			bRegistered = true;
+		}
+	}
+
+	return bRegistered;
+}
+
+void UAbilityInputHandler::UnregisterTriggeredAbility(UGameplayAbility_BaseTriggeredInputActionAbility* Ability)
+{
+	// Lists keep their capacity, so abilities activating and ending repeatedly never reallocate them
+	for (TPair<TObjectPtr<const UInputAction>, TArray<TWeakObjectPtr<UGameplayAbility_BaseTriggeredInputActionAbility>>>& ActionAbilities : TriggeredAbilitiesByAction)
+	{
+		const int32 Index = ActionAbilities.Value.Find(Ability);
+		if (Index != INDEX_NONE)
+		{
+			ActionAbilities.Value.RemoveAt(Index, 1, EAllowShrinking::No);
+		}
+	}
+}
+
+void UAbilityInputHandler::OnTriggeredInput(const FInputActionInstance& Instance)
+{
+	TriggeredInput(Instance.GetSourceAction(), Instance.GetValue());
+}
+
+void UAbilityInputHandler::BindComboActions(UEnhancedInputComponent* InputComp)
+{
+	ComboState.Reset();
+
+	// Canceled releases too, a chord must not stay armed on an action that never completed
+	for (const UInputAction* InputAction : InputConfig->GetComboMatcher().GetActions())
+	{
+		InputBindingHandles.Add(InputComp->BindAction(InputAction, ETriggerEvent::Started, this, &UAbilityInputHandler::OnComboInputPressed).GetHandle());
+		InputBindingHandles.Add(InputComp->BindAction(InputAction, ETriggerEvent::Completed, this, &UAbilityInputHandler::OnComboInputReleased).GetHandle());
+		InputBindingHandles.Add(InputComp->BindAction(InputAction, ETriggerEvent::Canceled, this, &UAbilityInputHandler::OnComboInputReleased).GetHandle());
+	}
+}
+
+void UAbilityInputHandler::OnComboInputPressed(const FInputActionInstance& Instance)
+{
+	ComboInput(Instance.GetSourceAction(), true);
+}
+
+void UAbilityInputHandler::OnComboInputReleased(const FInputActionInstance& Instance)
+{
+	ComboInput(Instance.GetSourceAction(), false);
+}
+
+void UAbilityInputHandler::ComboInput(const UInputAction* InputAction, bool bPressed)
+{
+	SCOPE_CYCLE_COUNTER(STAT_AbilityInputHandler_ComboInput);
+
+	if (!InputConfig)
+	{
+		return;
+	}
+
+	const FGASInputComboMatcher& ComboMatcher = InputConfig->GetComboMatcher();
+	const int32 Symbol = ComboMatcher.FindSymbol(InputAction);
+	if (Symbol == INDEX_NONE)
+	{
+		return;
+	}
+
+#if !UE_BUILD_SHIPPING
+	// Replaying the presses completes the combos again, the tag they send isn't recorded on its own
+	if (GASInputRecorder::IsRecording())
+	{
+		GASInputRecorder::RecordComboInput(*this, Symbol, bPressed);
+	}
+	TGuardValue<bool> RecordingGuard(GASInputRecorder::bIsRecording, false);
+#endif
+
+	if (!bPressed)
+	{
+		ComboMatcher.OnReleased(ComboState, Symbol);
+		return;
+	}
+
+	const FGASCompiledInputCombo* Combo = ComboMatcher.OnPressed(ComboState, Symbol, GetWorld()->GetTimeSeconds());
+	if (!Combo)
+	{
+		return;
+	}
+
+	// Only completed combos reach GAS, partial ones never try an activation
+	INC_DWORD_STAT(STAT_AbilityInputHandler_CombosCompleted);
+	switch (Combo->EventType)
+	{
+	case GASInputEventType::GameplayAbility:
+		AbilityInput(Combo->InputTag, ETriggerEvent::Started);
+		break;
+	case GASInputEventType::GameplayEvent:
+		EventInput(Combo->InputTag, ETriggerEvent::Started);
+		break;
+	case GASInputEventType::GameplayDynamic:
+		DynamicInput(Combo->InputTag, ETriggerEvent::Started);
+		break;
+	default:
+		break;
+	}
+}
+
+void UAbilityInputHandler::TriggeredInput(const UInputAction* InputAction, const FInputActionValue& Value)
+{
+	SCOPE_CYCLE_COUNTER(STAT_AbilityInputHandler_TriggeredInput);
+#if !UE_BUILD_SHIPPING
+	if (GASInputRecorder::IsRecording())
+	{
+		GASInputRecorder::RecordTriggeredValue(*this, InputAction, Value.Get<FVector>());
+	}
+#endif
+
+	TArray<TWeakObjectPtr<UGameplayAbility_BaseTriggeredInputActionAbility>>* Abilities = TriggeredAbilitiesByAction.Find(InputAction);
+	if (!Abilities)
+	{
+		return;
+	}
+
+	// Backwards, an ability may end and unregister itself while handling the value
+	for (int32 Index = Abilities->Num() - 1; Index >= 0; --Index)
+	{
+		if (!Abilities->IsValidIndex(Index))
+		{
+			continue;
+		}
+
+		if (UGameplayAbility_BaseTriggeredInputActionAbility* Ability = (*Abilities)[Index].Get())
+		{
+			Ability->OnTriggeredInputAction(Value);
+		}
+		else
+		{
+			Abilities->RemoveAt(Index, 1, EAllowShrinking::No);
+		}
+	}
+}
+
+void UAbilityInputHandler::OnControllerChanged(APawn* Pawn, AController* OldController, AController* NewController)
+{
+	SCOPE_CYCLE_COUNTER(STAT_AbilityInputHandler_Rebind);
+
+	// Mapping contexts live on the local player, a controller change on the same local player keeps them
+	if (GetInputSubsystem(OldController) != GetInputSubsystem(NewController))
+	{
+		//Remove Input Context Mappings provided by the Input Config from the old controller.
+		RemoveDefaultInputMappings(InputConfig, OldController);
+
+		//Add input Context Mappings provided by the Input Config to the new controller.
+		AddDefaultInputMappings(InputConfig, NewController);
+	}
+
+	// Only rebind when the pawn's input component changed, and only remove the bindings this handler made
+	if (BoundInputComponent.Get() != Pawn->InputComponent.Get())
+	{
+		UnbindFromInputConfig();
+		if (InputConfig)
+		{
+			BindToInputConfig();
+		}
+	}
+}
+
+void UAbilityInputHandler::UnbindFromInputConfig()
+{
+	if (UEnhancedInputComponent* InputComp = BoundInputComponent.Get())
+	{
+		for (const uint32 BindingHandle : InputBindingHandles)
+		{
+			InputComp->RemoveBindingByHandle(BindingHandle);
+		}
+	}
+
+	InputBindingHandles.Reset();
+	BoundInputComponent.Reset();
+}
+
+#if !UE_BUILD_SHIPPING
+
+bool GASDispatchInputBurst(UAbilityInputHandler& Handler, int32 Count, uint64& OutNumAllocations)
+{
+	OutNumAllocations = 0;
+	if (!Handler.InputConfig)
+	{
+		return false;
+	}
+
+	// Inputs without a bound tag and NotApplicable bindings never reach the handler
+	TArray<FGASInputBinding> Bindings;
+	for (const FGASInputBinding& Binding : Handler.InputConfig->GetCompiledBindings())
+	{
+		if (Binding.InputTag.IsValid() && Binding.EventType != GASInputEventType::NotApplicable)
+		{
+			Bindings.Add(Binding);
+		}
+	}
+
+	if (Bindings.IsEmpty())
+	{
+		return false;
+	}
+
+	// Every input of the burst lands in the same frame, measure the dispatch rather than the coalescing, and a failed input
+	// would only extend its buffered entry until the end of the burst instead of activating again
+	TGuardValue<bool> CoalesceGuard(Handler.bCoalesceInputPerFrame, false);
+	TGuardValue<float> BufferWindowGuard(Handler.InputBufferWindow, 0.f);
+
+	const auto Dispatch = [&Handler](const FGASInputBinding& Binding)
+	{
+		switch (Binding.EventType)
+		{
+		case GASInputEventType::GameplayAbility:
+			Handler.AbilityInput(Binding.InputTag, Binding.TriggerEvent);
+			break;
+		case GASInputEventType::GameplayEvent:
+			Handler.EventInput(Binding.InputTag, Binding.TriggerEvent);
+			break;
+		case GASInputEventType::GameplayDynamic:
+			Handler.DynamicInput(Binding.InputTag, Binding.TriggerEvent);
+			break;
+		default:
+			break;
+		}
+	};
+
+	// Warm up once so lazily built data (ability index, compiled bindings) isn't counted
+	for (const FGASInputBinding& Binding : Bindings)
+	{
+		Dispatch(Binding);
+	}
+
+	FGASScopedAllocationCounter AllocationCounter;
+	for (int32 Index = 0; Index < Count; ++Index)
+	{
+		Dispatch(Bindings[Index % Bindings.Num()]);
+	}
+	OutNumAllocations = AllocationCounter.GetNumAllocations();
+	return true;
+}
+
+/** Fires a burst of inputs through the local pawn's handler and reports the heap allocations made while dispatching them. */
+static FAutoConsoleCommandWithWorldAndArgs GASInputAllocationBurstCommand(
+	TEXT("GAS.Input.AllocationBurst"),
+	TEXT("Dispatches a burst of inputs (default 10000) through the local pawn's AbilityInputHandler and reports the game thread heap allocations.\n")
+	TEXT("Usage: GAS.Input.AllocationBurst [Count]. The GAS_Test.Input.DispatchAllocations automation test asserts the same on a test pawn."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		const APlayerController* PlayerController = World ? World->GetFirstPlayerController() : nullptr;
+		const APawn* Pawn = PlayerController ? PlayerController->GetPawn() : nullptr;
+		UAbilityInputHandler* Handler = Pawn ? Pawn->FindComponentByClass<UAbilityInputHandler>() : nullptr;
+		if (!Handler || !Handler->InputConfig)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("GAS.Input.AllocationBurst: the local pawn has no AbilityInputHandler with an input config."));
+			return;
+		}
+
+		const int32 Count = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 10000;
+		uint64 NumAllocations = 0;
+		if (Count <= 0 || !GASDispatchInputBurst(*Handler, Count, NumAllocations))
+		{
+			UE_LOG(LogTemp, Warning, TEXT("GAS.Input.AllocationBurst: nothing to dispatch."));
+			return;
+		}
+
+		UE_LOG(LogTemp, Log, TEXT("GAS.Input.AllocationBurst: %d inputs made %llu allocations (%s)."),
+			Count, NumAllocations, NumAllocations == 0 ? TEXT("PASS") : TEXT("FAIL"));
+	}));
+
+#endif // !UE_BUILD_SHIPPING
@@ -0,0 +1,71 @@
+﻿#include "AbilityStateCheckSignificance.h"
+#include "GameFramework/Actor.h"
+#include "GameFramework/Pawn.h"
+#include "HAL/IConsoleManager.h"
+
+static bool GAbilityStateCheckLODEnable = true;
+static FAutoConsoleVariableRef CVarAbilityStateCheckLODEnable(
+	TEXT("AbilityStateCheck.LOD.Enable"),
+	GAbilityStateCheckLODEnable,
+	TEXT("If true, State Tag Handlers with a significance object lower the evaluation rate of their checks when their owner isn't significant."),
+	ECVF_Default);
+
+float UAbilityStateCheckSignificance::CalculateSignificance_Implementation(const AActor* Owner, const TArray<FVector>& ViewLocations) const
+{
+	if (!Owner)
+	{
+		return 0.f;
+	}
+
+	if (const APawn* OwnerPawn = Cast<APawn>(Owner); OwnerPawn && OwnerPawn->IsPlayerControlled())
+	{
+		return 1.f;
+	}
+
+	const FVector OwnerLocation = Owner->GetActorLocation();
+	double ClosestDistanceSquared = TNumericLimits<double>::Max();
+	for (const FVector& ViewLocation : ViewLocations)
+	{
+		ClosestDistanceSquared = FMath::Min(ClosestDistanceSquared, FVector::DistSquared(OwnerLocation, ViewLocation));
+	}
+
+	float Significance = ViewLocations.IsEmpty() ? 0.f : 1.f - FMath::Clamp(static_cast<float>(FMath::Sqrt(ClosestDistanceSquared)) / MaxDistance, 0.f, 1.f);
+	if (Owner->WasRecentlyRendered(0.2f))
+	{
+		Significance = FMath::Max(Significance, RenderedSignificance);
+	}
+
+	return Significance;
+}
+
+EAbilityStateCheckLODTier UAbilityStateCheckSignificance::GetTier(float Significance) const
+{
+	if (Significance >= FullSignificance)
+	{
+		return EAbilityStateCheckLODTier::Full;
+	}
+	if (Significance >= ReducedSignificance)
+	{
+		return EAbilityStateCheckLODTier::Reduced;
+	}
+	if (Significance >= LowSignificance)
+	{
+		return EAbilityStateCheckLODTier::Low;
+	}
+	return EAbilityStateCheckLODTier::Suspended;
+}
+
+float UAbilityStateCheckSignificance::GetTierInterval(EAbilityStateCheckLODTier Tier) const
+{
+	switch (Tier)
+	{
+	case EAbilityStateCheckLODTier::Reduced:	return ReducedInterval;
+	case EAbilityStateCheckLODTier::Low:		return LowInterval;
+	default:									return 0.f;
+	}
+}
+
+bool UAbilityStateCheckSignificance::IsLODEnabled()
+{
+	return GAbilityStateCheckLODEnable;
+}
@@ -0,0 +1,389 @@
+﻿#include "AbilityStateCheckSubsystem.h"
+#include "AbilityStateCheck_Base.h"
+#include "AbilityStateTagHandler.h"
+#include "Async/ParallelFor.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "GASStats.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_CYCLE_STAT(TEXT("Scheduler Tick"), STAT_AbilityStateScheduler_Tick, STATGROUP_AbilityStateTags);
+DECLARE_CYCLE_STAT(TEXT("Scheduler Evaluate"), STAT_AbilityStateScheduler_Evaluate, STATGROUP_AbilityStateTags);
+DECLARE_CYCLE_STAT(TEXT("Scheduler Apply Results"), STAT_AbilityStateScheduler_Apply, STATGROUP_AbilityStateTags);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Scheduled Checks Evaluated"), STAT_AbilityStateScheduler_Evaluated, STATGROUP_AbilityStateTags);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Scheduled Checks Evaluated In Parallel"), STAT_AbilityStateScheduler_Parallel, STATGROUP_AbilityStateTags);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Scheduled Checks Deferred"), STAT_AbilityStateScheduler_Deferred, STATGROUP_AbilityStateTags);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Starved Checks Forced"), STAT_AbilityStateScheduler_Starved, STATGROUP_AbilityStateTags);
+
+static float GAbilityStateCheckFrameBudgetUs = 500.f;
+static FAutoConsoleVariableRef CVarAbilityStateCheckFrameBudgetUs(
+	TEXT("AbilityStateCheck.FrameBudgetUs"),
+	GAbilityStateCheckFrameBudgetUs,
+	TEXT("Time budget, in microseconds, the state check scheduler may spend evaluating checks each frame."),
+	ECVF_Default);
+
+static float GAbilityStateCheckUnmeasuredCostUs = 20.f;
+static FAutoConsoleVariableRef CVarAbilityStateCheckUnmeasuredCostUs(
+	TEXT("AbilityStateCheck.UnmeasuredCostUs"),
+	GAbilityStateCheckUnmeasuredCostUs,
+	TEXT("Cost, in microseconds, assumed for each check of a class the scheduler hasn't timed yet, so its first frame stays within the budget."),
+	ECVF_Default);
+
+static float GAbilityStateCheckMaxStarvationMs = 250.f;
+static FAutoConsoleVariableRef CVarAbilityStateCheckMaxStarvationMs(
+	TEXT("AbilityStateCheck.MaxStarvationMs"),
+	GAbilityStateCheckMaxStarvationMs,
+	TEXT("A due state check that has been waiting longer than this (in milliseconds) is evaluated regardless of the frame budget."),
+	ECVF_Default);
+
+static bool GAbilityStateCheckParallelEvaluation = true;
+static FAutoConsoleVariableRef CVarAbilityStateCheckParallelEvaluation(
+	TEXT("AbilityStateCheck.ParallelEvaluation"),
+	GAbilityStateCheckParallelEvaluation,
+	TEXT("If true, thread-safe state check classes are evaluated on worker threads."),
+	ECVF_Default);
+
+static int32 GAbilityStateCheckParallelMinBatchSize = 32;
+static FAutoConsoleVariableRef CVarAbilityStateCheckParallelMinBatchSize(
+	TEXT("AbilityStateCheck.ParallelMinBatchSize"),
+	GAbilityStateCheckParallelMinBatchSize,
+	TEXT("Minimum number of due checks of one class before they are spread over worker threads."),
+	ECVF_Default);
+
+void UAbilityStateCheckSubsystem::Deinitialize()
+{
+	Batches.Empty();
+	BatchIndexByClass.Empty();
+	DueEntryIds.Empty();
+	Results.Empty();
+	SharedStateChecks.Empty();
+
+	Super::Deinitialize();
+}
+
+TStatId UAbilityStateCheckSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UAbilityStateCheckSubsystem, STATGROUP_Tickables);
+}
+
+bool UAbilityStateCheckSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+FAbilityStateCheckEntryId UAbilityStateCheckSubsystem::RegisterStateCheck(UAbilityStateTagHandler* Handler, int32 CheckIndex,
+	UAbilityStateCheck_Base* StateCheck, const FAbilityStateCheckContext& Context, FAbilityStateCheckTransitionScratch& Scratch)
+{
+	check(Handler && StateCheck);
+
+	const UClass* CheckClass = StateCheck->GetClass();
+	int32 BatchIndex = INDEX_NONE;
+	if (const int32* FoundBatchIndex = BatchIndexByClass.Find(CheckClass))
+	{
+		BatchIndex = *FoundBatchIndex;
+	}
+	else
+	{
+		BatchIndex = Batches.AddDefaulted();
+		Batches[BatchIndex].CheckClass = CheckClass;
+		Batches[BatchIndex].bThreadSafe = StateCheck->IsThreadSafe();
+		BatchIndexByClass.Add(CheckClass, BatchIndex);
+	}
+
+	FAbilityStateCheckScheduleEntry Entry;
+	Entry.Handler = Handler;
+	Entry.StateCheck = StateCheck;
+	Entry.Context = &Context;
+	Entry.Scratch = &Scratch;
+	Entry.CheckIndex = CheckIndex;
+	Entry.Priority = StateCheck->GetPriority();
+	Entry.Interval = StateCheck->GetEvaluationInterval();
+	Entry.bEventDriven = StateCheck->IsEventDriven();
+	Entry.bOwningClientOnly = StateCheck->GetNetExecution() == EAbilityStateCheckNetExecution::OwningClientOnly;
+
+	// New checks are due straight away so they get their initial evaluation
+	Entry.DueTime = GetWorld()->GetTimeSeconds();
+
+	FAbilityStateCheckEntryId EntryId;
+	EntryId.BatchIndex = BatchIndex;
+	EntryId.EntryIndex = Batches[BatchIndex].Entries.Add(MoveTemp(Entry));
+	return EntryId;
+}
+
+UAbilityStateCheck_Base* UAbilityStateCheckSubsystem::GetSharedStateCheck(TSubclassOf<UAbilityStateCheck_Base> StateCheckClass)
+{
+	if (!StateCheckClass)
+	{
+		return nullptr;
+	}
+
+	TObjectPtr<UAbilityStateCheck_Base>& SharedStateCheck = SharedStateChecks.FindOrAdd(StateCheckClass);
+	if (!SharedStateCheck)
+	{
+		// Outered to the subsystem so it lives as long as the world and still finds it through GetWorld
+		SharedStateCheck = NewObject<UAbilityStateCheck_Base>(this, StateCheckClass);
+	}
+	return SharedStateCheck;
+}
+
+void UAbilityStateCheckSubsystem::UnregisterStateCheck(const FAbilityStateCheckEntryId& EntryId)
+{
+	if (FindEntry(EntryId))
+	{
+		Batches[EntryId.BatchIndex].Entries.RemoveAt(EntryId.EntryIndex);
+	}
+}
+
+void UAbilityStateCheckSubsystem::MarkStateCheckDirty(const FAbilityStateCheckEntryId& EntryId)
+{
+	if (FAbilityStateCheckScheduleEntry* Entry = FindEntry(EntryId))
+	{
+		// Keep the earliest due time so a check that is marked dirty repeatedly doesn't lose its place in the queue
+		Entry->DueTime = FMath::Min(Entry->DueTime, static_cast<double>(GetWorld()->GetTimeSeconds()));
+	}
+}
+
+void UAbilityStateCheckSubsystem::SetStateCheckLOD(const FAbilityStateCheckEntryId& EntryId, float LODInterval, bool bSuspended)
+{
+	if (FAbilityStateCheckScheduleEntry* Entry = FindEntry(EntryId))
+	{
+		// A check coming out of suspension is due now rather than starving since it was suspended
+		if (Entry->bSuspended && !bSuspended)
+		{
+			Entry->DueTime = FMath::Max(Entry->DueTime, static_cast<double>(GetWorld()->GetTimeSeconds()));
+		}
+
+		Entry->LODInterval = LODInterval;
+		Entry->bSuspended = bSuspended;
+	}
+}
+
+const TArray<FVector>& UAbilityStateCheckSubsystem::GetViewLocations()
+{
+	if (ViewLocationsFrame != GFrameCounter)
+	{
+		ViewLocationsFrame = GFrameCounter;
+		ViewLocations.Reset();
+
+		for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+		{
+			if (const APlayerController* PlayerController = It->Get())
+			{
+				FVector ViewLocation;
+				FRotator ViewRotation;
+				PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+				ViewLocations.Add(ViewLocation);
+			}
+		}
+	}
+
+	return ViewLocations;
+}
+
+FAbilityStateCheckScheduleEntry* UAbilityStateCheckSubsystem::FindEntry(const FAbilityStateCheckEntryId& EntryId)
+{
+	if (Batches.IsValidIndex(EntryId.BatchIndex) && Batches[EntryId.BatchIndex].Entries.IsValidIndex(EntryId.EntryIndex))
+	{
+		return &Batches[EntryId.BatchIndex].Entries[EntryId.EntryIndex];
+	}
+	return nullptr;
+}
+
+void UAbilityStateCheckSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_AbilityStateScheduler_Tick);
+
+	Super::Tick(DeltaTime);
+
+	const double Now = GetWorld()->GetTimeSeconds();
+	const double StarvationLimit = GAbilityStateCheckMaxStarvationMs * 0.001;
+
+	// Gather every due entry, dropping the ones whose handler has gone away
+	DueEntryIds.Reset();
+	GatedEntryIds.Reset();
+	for (int32 BatchIndex = 0; BatchIndex < Batches.Num(); ++BatchIndex)
+	{
+		for (auto It = Batches[BatchIndex].Entries.CreateIterator(); It; ++It)
+		{
+			if (!It->Handler.IsValid())
+			{
+				It.RemoveCurrent();
+			}
+			else if (!It->bSuspended && It->DueTime <= Now)
+			{
+				if (It->bOwningClientOnly && !It->Handler->bOwnerLocallyControlled)
+				{
+					// The handler marks the check dirty when its owner becomes locally controlled again
+					It->DueTime = TNumericLimits<double>::Max();
+					GatedEntryIds.Add({ BatchIndex, It.GetIndex() });
+				}
+				else
+				{
+					DueEntryIds.Add({ BatchIndex, It.GetIndex() });
+				}
+			}
+		}
+	}
+
+	// Gated checks aren't run nor charged to the budget, they only drop the tags they granted while parked
+	for (const FAbilityStateCheckEntryId& EntryId : GatedEntryIds)
+	{
+		if (FAbilityStateCheckScheduleEntry* Entry = FindEntry(EntryId); Entry && Entry->Handler.IsValid())
+		{
+			Entry->Handler->ApplyStateCheckResult(Entry->CheckIndex, false);
+			Entry->Handler->FlushStateTags();
+		}
+	}
+
+	if (DueEntryIds.Num() == 0)
+	{
+		return;
+	}
+
+	// Starving checks first, then by priority, then oldest first so skipped checks move up the queue (round-robin)
+	DueEntryIds.Sort([this, Now, StarvationLimit](const FAbilityStateCheckEntryId& A, const FAbilityStateCheckEntryId& B)
+	{
+		const FAbilityStateCheckScheduleEntry& EntryA = Batches[A.BatchIndex].Entries[A.EntryIndex];
+		const FAbilityStateCheckScheduleEntry& EntryB = Batches[B.BatchIndex].Entries[B.EntryIndex];
+
+		const bool bStarvingA = Now - EntryA.DueTime >= StarvationLimit;
+		const bool bStarvingB = Now - EntryB.DueTime >= StarvationLimit;
+		if (bStarvingA != bStarvingB)
+		{
+			return bStarvingA;
+		}
+		if (EntryA.Priority != EntryB.Priority)
+		{
+			return EntryA.Priority > EntryB.Priority;
+		}
+		return EntryA.DueTime < EntryB.DueTime;
+	});
+
+	// Select as many entries as the budget allows, based on the measured cost of each class, or a conservative guess for
+	// classes not evaluated yet. Always select at least one so a single expensive check can't stall the queue.
+	const double BudgetSeconds = GAbilityStateCheckFrameBudgetUs * 0.000001;
+	const double UnmeasuredCostSeconds = GAbilityStateCheckUnmeasuredCostUs * 0.000001;
+	double EstimatedCost = 0.0;
+	int32 NumSelected = 0;
+	for (; NumSelected < DueEntryIds.Num(); ++NumSelected)
+	{
+		const FAbilityStateCheckEntryId& EntryId = DueEntryIds[NumSelected];
+		FAbilityStateCheckBatch& Batch = Batches[EntryId.BatchIndex];
+		FAbilityStateCheckScheduleEntry& Entry = Batch.Entries[EntryId.EntryIndex];
+		const bool bStarving = Now - Entry.DueTime >= StarvationLimit;
+
+		if (!bStarving && NumSelected > 0 && EstimatedCost >= BudgetSeconds)
+		{
+			break;
+		}
+
+		if (bStarving)
+		{
+			INC_DWORD_STAT(STAT_AbilityStateScheduler_Starved);
+		}
+		EstimatedCost += Batch.AverageCostSeconds > 0.0 ? Batch.AverageCostSeconds : UnmeasuredCostSeconds;
+
+		// Reschedule before evaluating, as the check may mark itself or others dirty
+		Entry.DueTime = Entry.bEventDriven ? TNumericLimits<double>::Max() : Now + FMath::Max(Entry.Interval, Entry.LODInterval);
+	}
+
+	INC_DWORD_STAT_BY(STAT_AbilityStateScheduler_Deferred, DueEntryIds.Num() - NumSelected);
+	DueEntryIds.SetNum(NumSelected, EAllowShrinking::No);
+
+	// Group the selection by class so each batch is evaluated in one go
+	DueEntryIds.StableSort([](const FAbilityStateCheckEntryId& A, const FAbilityStateCheckEntryId& B)
+	{
+		return A.BatchIndex < B.BatchIndex;
+	});
+
+	// Each result starts as the current one, checks with an exit condition evaluate it instead while passing
+	Results.SetNumUninitialized(NumSelected, EAllowShrinking::No);
+	for (int32 Index = 0; Index < NumSelected; ++Index)
+	{
+		const FAbilityStateCheckScheduleEntry* Entry = FindEntry(DueEntryIds[Index]);
+		const UAbilityStateTagHandler* Handler = Entry ? Entry->Handler.Get() : nullptr;
+		Results[Index] = Handler && Handler->StateCheckResults[Entry->CheckIndex];
+	}
+
+	{
+		SCOPE_CYCLE_COUNTER(STAT_AbilityStateScheduler_Evaluate);
+
+		int32 RangeStart = 0;
+		while (RangeStart < NumSelected)
+		{
+			const int32 BatchIndex = DueEntryIds[RangeStart].BatchIndex;
+			int32 RangeEnd = RangeStart + 1;
+			while (RangeEnd < NumSelected && DueEntryIds[RangeEnd].BatchIndex == BatchIndex)
+			{
+				++RangeEnd;
+			}
+
+			const int32 RangeNum = RangeEnd - RangeStart;
+			const double BatchStartTime = FPlatformTime::Seconds();
+
+			if (Batches[BatchIndex].bThreadSafe && GAbilityStateCheckParallelEvaluation)
+			{
+				// Read-only checks, nothing is written besides the results array
+				const FAbilityStateCheckBatch& Batch = Batches[BatchIndex];
+				const bool bSingleThread = RangeNum < GAbilityStateCheckParallelMinBatchSize;
+				ParallelFor(RangeNum, [this, &Batch, RangeStart](int32 Offset)
+				{
+					const FAbilityStateCheckEntryId& EntryId = DueEntryIds[RangeStart + Offset];
+					const FAbilityStateCheckScheduleEntry& Entry = Batch.Entries[EntryId.EntryIndex];
+					bool& Result = Results[RangeStart + Offset];
+					Result = Entry.StateCheck->EvaluateTransition(*Entry.Context, *Entry.Scratch, Result);
+				}, bSingleThread);
+
+				INC_DWORD_STAT_BY(STAT_AbilityStateScheduler_Parallel, RangeNum);
+			}
+			else
+			{
+				for (int32 Index = RangeStart; Index < RangeEnd; ++Index)
+				{
+					// Blueprint checks can spawn or destroy actors, registering or unregistering entries as they run
+					const FAbilityStateCheckScheduleEntry* Entry = FindEntry(DueEntryIds[Index]);
+					Results[Index] = Entry && Entry->Handler.IsValid() && Entry->StateCheck->EvaluateTransition(*Entry->Context, *Entry->Scratch, Results[Index]);
+				}
+			}
+
+			// Exponential moving average of the per-check cost of this class
+			FAbilityStateCheckBatch& Batch = Batches[BatchIndex];
+			const double CostPerCheck = (FPlatformTime::Seconds() - BatchStartTime) / RangeNum;
+			Batch.AverageCostSeconds = Batch.AverageCostSeconds > 0.0
+				? FMath::Lerp(Batch.AverageCostSeconds, CostPerCheck, 0.1)
+				: CostPerCheck;
+
+			RangeStart = RangeEnd;
+		}
+	}
+
+	{
+		SCOPE_CYCLE_COUNTER(STAT_AbilityStateScheduler_Apply);
+
+		// Apply the results on the game thread, tag changes may mark other checks dirty or end play on their owner
+		for (int32 Index = 0; Index < NumSelected; ++Index)
+		{
+			FAbilityStateCheckScheduleEntry* Entry = FindEntry(DueEntryIds[Index]);
+			if (!Entry || !Entry->Handler.IsValid())
+			{
+				continue;
+			}
+
+			Entry->Handler->ApplyStateCheckResult(Entry->CheckIndex, Results[Index]);
+		}
+
+		// Each handler applies all of its tag changes for this frame at once
+		for (int32 Index = 0; Index < NumSelected; ++Index)
+		{
+			if (FAbilityStateCheckScheduleEntry* Entry = FindEntry(DueEntryIds[Index]))
+			{
+				if (UAbilityStateTagHandler* Handler = Entry->Handler.Get())
+				{
+					Handler->FlushStateTags();
+				}
+			}
+		}
+	}
+
+	INC_DWORD_STAT_BY(STAT_AbilityStateScheduler_Evaluated, NumSelected);
+}
@@ -1,5 +1,6 @@
 ﻿
 #include "AbilityStateCheck_Base.h"
+#include "AbilityStateTagHandler.h"
 #include "UObject/Package.h"
 
 /**
@@ -32,3 +33,58 @@ bool UAbilityStateCheck_Base::IsInstantiated() const
 	// If the flag is present, this means the object is a CDO.
 	return !HasAllFlags(RF_ClassDefaultObject);
 }
+
+/**
+ * Caches whether 'Run' has a Blueprint implementation, so native-only classes never go through ProcessEvent.
+ */
+void UAbilityStateCheck_Base::PostInitProperties()
+{
+	Super::PostInitProperties();
+
+	bRunImplementedInScript = GetClass()->IsFunctionImplementedInScript(GET_FUNCTION_NAME_CHECKED(UAbilityStateCheck_Base, Run));
+}
+
+/**
+ * Default evaluation, running the Blueprint 'Run' event if there is one.
+ */
+bool UAbilityStateCheck_Base::Evaluate(const FAbilityStateCheckContext& Context)
+{
+	return bRunImplementedInScript && Run(Context.Owner);
+}
+
+/**
+ * Default evaluation with scratch memory, for checks that don't use it.
+ */
+bool UAbilityStateCheck_Base::EvaluateWithScratch(const FAbilityStateCheckContext& Context, FAbilityStateCheckScratch& Scratch)
+{
+	return Evaluate(Context);
+}
+
+/**
+ * Hysteresis: the exit condition, when there is one, decides when a passing check stops passing.
+ */
+bool UAbilityStateCheck_Base::EvaluateTransition(const FAbilityStateCheckContext& Context, FAbilityStateCheckTransitionScratch& Scratch, bool bCurrentlyPassing)
+{
+	if (bCurrentlyPassing && ExitCondition)
+	{
+		return !ExitCondition->EvaluateWithScratch(Context, Scratch.ExitCondition);
+	}
+	return EvaluateWithScratch(Context, Scratch.Check);
+}
+
+/**
+ * Forwards a dirty request to the State Tag Handler that instantiated this check.
+ * Every frame checks are re-run anyway, so this only matters for event-driven checks.
+ */
+void UAbilityStateCheck_Base::MarkDirty()
+{
+	if (UAbilityStateTagHandler* Handler = Cast<UAbilityStateTagHandler>(GetOuter()))
+	{
+		Handler->MarkStateCheckDirty(this);
+	}
+	else
+	{
+		// A shared instance doesn't know which actor it is marked dirty for
+		UE_LOG(LogTemp, Warning, TEXT("%s is shared between actors, mark it dirty through the State Tag Handler instead."), *GetName());
+	}
+}
@@ -0,0 +1,88 @@
+﻿#include "AbilityStateCheck_Native.h"
+#include "AbilitySystemComponent.h"
+#include "GameFramework/Character.h"
+#include "GameFramework/CharacterMovementComponent.h"
+
+bool AbilityStateCheck::Compare(float Value, EAbilityStateComparison Comparison, float Threshold)
+{
+	switch (Comparison)
+	{
+	case EAbilityStateComparison::Less:
+		return Value < Threshold;
+	case EAbilityStateComparison::LessOrEqual:
+		return Value <= Threshold;
+	case EAbilityStateComparison::Greater:
+		return Value > Threshold;
+	case EAbilityStateComparison::GreaterOrEqual:
+		return Value >= Threshold;
+	case EAbilityStateComparison::Equal:
+		return FMath::IsNearlyEqual(Value, Threshold);
+	case EAbilityStateComparison::NotEqual:
+		return !FMath::IsNearlyEqual(Value, Threshold);
+	default:
+		return false;
+	}
+}
+
+UAbilityStateCheck_MovementMode::UAbilityStateCheck_MovementMode()
+{
+	bThreadSafe = true;
+	bStateless = true;
+}
+
+bool UAbilityStateCheck_MovementMode::Evaluate(const FAbilityStateCheckContext& Context)
+{
+	const UCharacterMovementComponent* MovementComponent = Context.Character ? Context.Character->GetCharacterMovement() : nullptr;
+	if (!MovementComponent)
+	{
+		return false;
+	}
+
+	const EMovementMode CurrentMode = MovementComponent->MovementMode;
+	if (!MovementModes.Contains(CurrentMode))
+	{
+		return false;
+	}
+
+	// Narrow custom movement down to a specific custom mode if one is set
+	return CurrentMode != MOVE_Custom || CustomMovementMode < 0 || MovementComponent->CustomMovementMode == CustomMovementMode;
+}
+
+UAbilityStateCheck_AttributeThreshold::UAbilityStateCheck_AttributeThreshold()
+{
+	bThreadSafe = true;
+	bStateless = true;
+}
+
+bool UAbilityStateCheck_AttributeThreshold::Evaluate(const FAbilityStateCheckContext& Context)
+{
+	bool bFound = false;
+	const float Value = Context.AbilitySystem->GetGameplayAttributeValue(Attribute, bFound);
+
+	return bFound && AbilityStateCheck::Compare(Value, Comparison, Threshold);
+}
+
+UAbilityStateCheck_TagQuery::UAbilityStateCheck_TagQuery()
+{
+	bThreadSafe = true;
+	bStateless = true;
+}
+
+bool UAbilityStateCheck_TagQuery::Evaluate(const FAbilityStateCheckContext& Context)
+{
+	return !Query.IsEmpty() && Query.Matches(Context.AbilitySystem->GetOwnedGameplayTags());
+}
+
+UAbilityStateCheck_Velocity::UAbilityStateCheck_Velocity()
+{
+	bThreadSafe = true;
+	bStateless = true;
+}
+
+bool UAbilityStateCheck_Velocity::Evaluate(const FAbilityStateCheckContext& Context)
+{
+	const FVector Velocity = Context.Owner->GetVelocity();
+	const float Speed = bHorizontalOnly ? Velocity.Size2D() : Velocity.Size();
+
+	return AbilityStateCheck::Compare(Speed, Comparison, Threshold);
+}
@@ -0,0 +1,211 @@
+﻿#include "AbilityStateCondition.h"
+#include "AbilityStateCheck_Base.h"
+#include "AbilitySystemComponent.h"
+#include "GameFramework/Character.h"
+#include "GameFramework/CharacterMovementComponent.h"
+
+int32 FAbilityStateConditionProgram::AddNode(EAbilityStateConditionOp Op)
+{
+	FAbilityStateConditionNode& Node = Nodes.AddDefaulted_GetRef();
+	Node.Op = Op;
+	return Nodes.Num() - 1;
+}
+
+void FAbilityStateConditionProgram::FinishNode(int32 NodeIndex, int32 NumChildren)
+{
+	FAbilityStateConditionNode& Node = Nodes[NodeIndex];
+	Node.NumChildren = static_cast<uint16>(NumChildren);
+	Node.SubtreeSize = static_cast<uint16>(Nodes.Num() - NodeIndex);
+}
+
+bool FAbilityStateConditionProgram::Evaluate(const FAbilityStateCheckContext& Context) const
+{
+	return !Nodes.IsEmpty() && EvaluateNode(Context, 0);
+}
+
+void FAbilityStateConditionProgram::Reset()
+{
+	Nodes.Reset();
+	TagQueries.Reset();
+	Attributes.Reset();
+}
+
+bool FAbilityStateConditionProgram::EvaluateNode(const FAbilityStateCheckContext& Context, int32 NodeIndex) const
+{
+	const FAbilityStateConditionNode& Node = Nodes[NodeIndex];
+	switch (Node.Op)
+	{
+	case EAbilityStateConditionOp::And:
+	case EAbilityStateConditionOp::Or:
+	{
+		// Children follow their parent, each one is skipped over by its subtree size
+		const bool bShortCircuitValue = Node.Op == EAbilityStateConditionOp::Or;
+		int32 ChildIndex = NodeIndex + 1;
+		for (int32 Child = 0; Child < Node.NumChildren; ++Child)
+		{
+			if (EvaluateNode(Context, ChildIndex) == bShortCircuitValue)
+			{
+				return bShortCircuitValue;
+			}
+			ChildIndex += Nodes[ChildIndex].SubtreeSize;
+		}
+		return !bShortCircuitValue;
+	}
+	case EAbilityStateConditionOp::Not:
+		return Node.NumChildren > 0 && !EvaluateNode(Context, NodeIndex + 1);
+	case EAbilityStateConditionOp::TagQuery:
+		return TagQueries[Node.Operand].Matches(Context.AbilitySystem->GetOwnedGameplayTags());
+	case EAbilityStateConditionOp::Attribute:
+	{
+		bool bFound = false;
+		const float Value = Context.AbilitySystem->GetGameplayAttributeValue(Attributes[Node.Operand], bFound);
+		return bFound && AbilityStateCheck::Compare(Value, Node.Comparison, Node.Threshold);
+	}
+	case EAbilityStateConditionOp::MovementMode:
+	{
+		const UCharacterMovementComponent* MovementComponent = Context.Character ? Context.Character->GetCharacterMovement() : nullptr;
+		if (!MovementComponent || !(Node.Operand & (1 << MovementComponent->MovementMode)))
+		{
+			return false;
+		}
+		return MovementComponent->MovementMode != MOVE_Custom || Node.CustomMovementMode < 0
+			|| MovementComponent->CustomMovementMode == Node.CustomMovementMode;
+	}
+	case EAbilityStateConditionOp::Crouched:
+		return Context.Character && Context.Character->bIsCrouched;
+	case EAbilityStateConditionOp::Speed:
+	{
+		const FVector Velocity = Context.Owner->GetVelocity();
+		return AbilityStateCheck::Compare(Node.Operand ? Velocity.Size2D() : Velocity.Size(), Node.Comparison, Node.Threshold);
+	}
+	default:
+		return false;
+	}
+}
+
+void UAbilityStateCondition_And::Compile(FAbilityStateConditionProgram& Program) const
+{
+	const int32 NodeIndex = Program.AddNode(EAbilityStateConditionOp::And);
+	int32 NumChildren = 0;
+	for (const UAbilityStateCondition* Condition : Conditions)
+	{
+		if (Condition)
+		{
+			Condition->Compile(Program);
+			++NumChildren;
+		}
+	}
+	Program.FinishNode(NodeIndex, NumChildren);
+}
+
+void UAbilityStateCondition_Or::Compile(FAbilityStateConditionProgram& Program) const
+{
+	const int32 NodeIndex = Program.AddNode(EAbilityStateConditionOp::Or);
+	int32 NumChildren = 0;
+	for (const UAbilityStateCondition* Condition : Conditions)
+	{
+		if (Condition)
+		{
+			Condition->Compile(Program);
+			++NumChildren;
+		}
+	}
+	Program.FinishNode(NodeIndex, NumChildren);
+}
+
+void UAbilityStateCondition_Not::Compile(FAbilityStateConditionProgram& Program) const
+{
+	const int32 NodeIndex = Program.AddNode(EAbilityStateConditionOp::Not);
+	if (Condition)
+	{
+		Condition->Compile(Program);
+	}
+	Program.FinishNode(NodeIndex, Condition ? 1 : 0);
+}
+
+void UAbilityStateCondition_TagQuery::Compile(FAbilityStateConditionProgram& Program) const
+{
+	const int32 NodeIndex = Program.AddNode(EAbilityStateConditionOp::TagQuery);
+	Program.Nodes[NodeIndex].Operand = Program.TagQueries.Add(Query);
+}
+
+void UAbilityStateCondition_Attribute::Compile(FAbilityStateConditionProgram& Program) const
+{
+	const int32 NodeIndex = Program.AddNode(EAbilityStateConditionOp::Attribute);
+	FAbilityStateConditionNode& Node = Program.Nodes[NodeIndex];
+	Node.Operand = Program.Attributes.AddUnique(Attribute);
+	Node.Comparison = Comparison;
+	Node.Threshold = Threshold;
+}
+
+void UAbilityStateCondition_MovementMode::Compile(FAbilityStateConditionProgram& Program) const
+{
+	const int32 NodeIndex = Program.AddNode(EAbilityStateConditionOp::MovementMode);
+	FAbilityStateConditionNode& Node = Program.Nodes[NodeIndex];
+	for (const TEnumAsByte<EMovementMode> MovementMode : MovementModes)
+	{
+		Node.Operand |= 1 << MovementMode.GetValue();
+	}
+	Node.CustomMovementMode = static_cast<int16>(CustomMovementMode);
+}
+
+void UAbilityStateCondition_Crouched::Compile(FAbilityStateConditionProgram& Program) const
+{
+	Program.AddNode(EAbilityStateConditionOp::Crouched);
+}
+
+void UAbilityStateCondition_Speed::Compile(FAbilityStateConditionProgram& Program) const
+{
+	const int32 NodeIndex = Program.AddNode(EAbilityStateConditionOp::Speed);
+	FAbilityStateConditionNode& Node = Program.Nodes[NodeIndex];
+	Node.Operand = bHorizontalOnly ? 1 : 0;
+	Node.Comparison = Comparison;
+	Node.Threshold = Threshold;
+}
+
+UAbilityStateCheck_Expression::UAbilityStateCheck_Expression()
+{
+	bThreadSafe = true;
+	bStateless = true;
+}
+
+void UAbilityStateCheck_Expression::PostInitProperties()
+{
+	Super::PostInitProperties();
+
+	// Instances created from a template get the template's condition but not its program
+	if (IsInstantiated())
+	{
+		CompileCondition();
+	}
+}
+
+void UAbilityStateCheck_Expression::PostLoad()
+{
+	Super::PostLoad();
+
+	CompileCondition();
+}
+
+#if WITH_EDITOR
+void UAbilityStateCheck_Expression::PostEditChangeChainProperty(FPropertyChangedChainEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeChainProperty(PropertyChangedEvent);
+
+	CompileCondition();
+}
+#endif
+
+bool UAbilityStateCheck_Expression::Evaluate(const FAbilityStateCheckContext& Context)
+{
+	return Program.Evaluate(Context);
+}
+
+void UAbilityStateCheck_Expression::CompileCondition()
+{
+	Program.Reset();
+	if (Condition)
+	{
+		Condition->Compile(Program);
+	}
+}
@@ -1,17 +1,236 @@
 ﻿// Fill out your copyright notice in the Description page of Project Settings.
 
 #include "AbilityStateTagHandler.h"
-#include "AbilitySystemBlueprintLibrary.h"
+#include "AbilityStateCheckSubsystem.h"
+#include "AbilityStateCondition.h"
+#include "Containers/Ticker.h"
+#include "Engine/AssetManager.h"
+#include "GameFramework/Character.h"
+#include "GASStats.h"
+#include "HAL/IConsoleManager.h"
+#include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
+#include "TimerManager.h"
+
+DECLARE_CYCLE_STAT(TEXT("State Check Tick"), STAT_AbilityStateTagHandler_Tick, STATGROUP_AbilityStateTags);
+DECLARE_CYCLE_STAT(TEXT("Flush State Tags"), STAT_AbilityStateTagHandler_FlushTags, STATGROUP_AbilityStateTags);
+DECLARE_DWORD_COUNTER_STAT(TEXT("State Tags Added"), STAT_AbilityStateTagHandler_TagsAdded, STATGROUP_AbilityStateTags);
+DECLARE_DWORD_COUNTER_STAT(TEXT("State Tags Removed"), STAT_AbilityStateTagHandler_TagsRemoved, STATGROUP_AbilityStateTags);
+DECLARE_CYCLE_STAT(TEXT("Compact Tag Replication"), STAT_AbilityStateTagHandler_CompactReplication, STATGROUP_AbilityStateTags);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Compact Tag Bit Updates"), STAT_AbilityStateTagHandler_CompactBitUpdates, STATGROUP_AbilityStateTags);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Replicated Loose Tag Changes"), STAT_AbilityStateTagHandler_ReplicatedLooseTagChanges, STATGROUP_AbilityStateTags);
+DECLARE_DWORD_COUNTER_STAT(TEXT("State Check LOD Transitions"), STAT_AbilityStateTagHandler_LODTransitions, STATGROUP_AbilityStateTags);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Handlers At Reduced LOD"), STAT_AbilityStateTagHandler_ReducedLOD, STATGROUP_AbilityStateTags);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Handlers At Low LOD"), STAT_AbilityStateTagHandler_LowLOD, STATGROUP_AbilityStateTags);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Handlers Suspended"), STAT_AbilityStateTagHandler_SuspendedLOD, STATGROUP_AbilityStateTags);
+DECLARE_DWORD_COUNTER_STAT(TEXT("State Check Transitions"), STAT_AbilityStateTagHandler_Transitions, STATGROUP_AbilityStateTags);
+DECLARE_DWORD_COUNTER_STAT(TEXT("State Check Transitions Held Back"), STAT_AbilityStateTagHandler_TransitionsHeldBack, STATGROUP_AbilityStateTags);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("State Check Transitions Per Second"), STAT_AbilityStateTagHandler_TransitionsPerSecond, STATGROUP_AbilityStateTags);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Shared State Check References"), STAT_AbilityStateTagHandler_SharedChecks, STATGROUP_AbilityStateTags);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Instanced State Checks"), STAT_AbilityStateTagHandler_InstancedChecks, STATGROUP_AbilityStateTags);
+
+namespace AbilityStateTagHandlerTransitions
+{
+#if STATS
+	static int32 NumTransitions = 0;
+	static double WindowStartTime = 0.0;
+	static double TransitionsPerSecond = 0.0;
+	static FTSTicker::FDelegateHandle TickerHandle;
+
+	/** Publishes the number of changes per second over the last second or so, every frame so it drops to 0 once they stop. */
+	static bool Tick(float DeltaTime)
+	{
+		const double Now = FPlatformTime::Seconds();
+		const double Elapsed = Now - WindowStartTime;
+		if (Elapsed >= 1.0)
+		{
+			TransitionsPerSecond = NumTransitions / Elapsed;
+			NumTransitions = 0;
+			WindowStartTime = Now;
+		}
+
+		SET_FLOAT_STAT(STAT_AbilityStateTagHandler_TransitionsPerSecond, TransitionsPerSecond);
+		return true;
+	}
+#endif
+
+	/** Counts a change of applied result. */
+	static void Record()
+	{
+		INC_DWORD_STAT(STAT_AbilityStateTagHandler_Transitions);
+
+#if STATS
+		++NumTransitions;
+
+		// Started by the first change, nothing to publish before
+		if (!TickerHandle.IsValid())
+		{
+			WindowStartTime = FPlatformTime::Seconds();
+			TickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateStatic(&AbilityStateTagHandlerTransitions::Tick));
+		}
+#endif
+	}
+}
+
+static bool GAbilityStateCheckCompactTagReplication = true;
+static FAutoConsoleVariableRef CVarAbilityStateCheckCompactTagReplication(
+	TEXT("AbilityStateCheck.CompactTagReplication"),
+	GAbilityStateCheckCompactTagReplication,
+	TEXT("If false, handlers with compact tag replication replicate their tags as loose tags instead, to compare the server cost of both. Set it on every machine, applies to handlers registered afterwards."),
+	ECVF_Default);
+
+static bool GAbilityStateCheckShareStateless = true;
+static FAutoConsoleVariableRef CVarAbilityStateCheckShareStateless(
+	TEXT("AbilityStateCheck.ShareStatelessChecks"),
+	GAbilityStateCheckShareStateless,
+	TEXT("If true, state checks flagged Stateless use one instance per world instead of one per actor. Applies to handlers initialized afterwards."),
+	ECVF_Default);
+
+namespace AbilityStateTagHandlerLOD
+{
+	/** Keeps the per-tier handler counts in sync with a tier change. */
+	static void TrackTier(EAbilityStateCheckLODTier Tier, int32 Delta)
+	{
+		switch (Tier)
+		{
+		case EAbilityStateCheckLODTier::Reduced:	INC_DWORD_STAT_BY(STAT_AbilityStateTagHandler_ReducedLOD, Delta); break;
+		case EAbilityStateCheckLODTier::Low:		INC_DWORD_STAT_BY(STAT_AbilityStateTagHandler_LowLOD, Delta); break;
+		case EAbilityStateCheckLODTier::Suspended:	INC_DWORD_STAT_BY(STAT_AbilityStateTagHandler_SuspendedLOD, Delta); break;
+		default: break;
+		}
+	}
+}
+
+bool FAbilityStateTagBits::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	// The tag table is shared by both sides, only its size and the bits themselves are sent
+	uint32 NumBits = Bits.Num();
+	Ar.SerializeIntPacked(NumBits);
+
+	if (Ar.IsLoading())
+	{
+		constexpr uint32 MaxBits = 1024;
+		if (NumBits > MaxBits)
+		{
+			bOutSuccess = false;
+			return false;
+		}
+		Bits.Init(false, NumBits);
+	}
+
+	if (NumBits > 0)
+	{
+		Ar.SerializeBits(Bits.GetData(), NumBits);
+	}
+
+	bOutSuccess = true;
+	return true;
+}
+
+const TArray<FGameplayTag>& UAbilityStateCheckObjects::GetReplicatedTagTable() const
+{
+	if (!bReplicatedTagTableBuilt)
+	{
+		ReplicatedTagTable.Reset();
+		const auto AddReplicatedTags = [this](const UAbilityStateCheck_Base* StateCheck)
+		{
+			if (StateCheck && StateCheck->ShouldReplicate())
+			{
+				for (const FGameplayTag& Tag : StateCheck->GetTagsToAdd())
+				{
+					ReplicatedTagTable.AddUnique(Tag);
+				}
+			}
+		};
+
+		for (const TSubclassOf<UAbilityStateCheck_Base>& StateCheckClass : StateChecks)
+		{
+			AddReplicatedTags(StateCheckClass ? StateCheckClass->GetDefaultObject<UAbilityStateCheck_Base>() : nullptr);
+		}
+		for (const UAbilityStateCheck_Base* InlineStateCheck : InlineStateChecks)
+		{
+			AddReplicatedTags(InlineStateCheck);
+		}
+
+		// Sort by name rather than by FName index, which differs between processes
+		ReplicatedTagTable.Sort([](const FGameplayTag& A, const FGameplayTag& B)
+		{
+			return A.GetTagName().LexicalLess(B.GetTagName());
+		});
+		bReplicatedTagTableBuilt = true;
+	}
+	return ReplicatedTagTable;
+}
+
+#if WITH_EDITOR
+void UAbilityStateCheckObjects::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	bReplicatedTagTableBuilt = false;
+}
+
+void UAbilityStateCheckObjects::PostEditChangeChainProperty(FPropertyChangedChainEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeChainProperty(PropertyChangedEvent);
+
+	// Edits to a condition nested in an inline check are only reported to the asset
+	for (UAbilityStateCheck_Base* InlineStateCheck : InlineStateChecks)
+	{
+		if (UAbilityStateCheck_Expression* ExpressionCheck = Cast<UAbilityStateCheck_Expression>(InlineStateCheck))
+		{
+			ExpressionCheck->CompileCondition();
+		}
+	}
+	bReplicatedTagTableBuilt = false;
+}
+#endif
 
 UAbilityStateTagHandler::UAbilityStateTagHandler()
 {
 	PrimaryComponentTick.bCanEverTick = true;
 }
 
+void UAbilityStateTagHandler::OnRegister()
+{
+	Super::OnRegister();
+
+	// Only replicated for the state tag bits, handlers without compact tag replication stay off the actor's replicated components
+	bReplicateStateTagBits = bCompactTagReplication && GAbilityStateCheckCompactTagReplication;
+	SetIsReplicated(bReplicateStateTagBits);
+}
+
 void UAbilityStateTagHandler::BeginPlay()
 {
 	Super::BeginPlay();
 
+	// Stream the soft asset in, the checks start once it is loaded
+	if (!AbilityStateTag && !SoftAbilityStateTag.IsNull())
+	{
+		SetComponentTickEnabled(false);
+		StateCheckLoadHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(SoftAbilityStateTag.ToSoftObjectPath(),
+			FStreamableDelegate::CreateUObject(this, &UAbilityStateTagHandler::OnStateCheckObjectsLoaded));
+		return;
+	}
+
+	InitializeStateChecks();
+}
+
+void UAbilityStateTagHandler::OnStateCheckObjectsLoaded()
+{
+	StateCheckLoadHandle.Reset();
+
+	AbilityStateTag = SoftAbilityStateTag.Get();
+	if (AbilityStateTag)
+	{
+		SetComponentTickEnabled(true);
+	}
+
+	InitializeStateChecks();
+}
+
+void UAbilityStateTagHandler::InitializeStateChecks()
+{
 	// Early return if AbilityStateTag is null
 	if (!AbilityStateTag)
 	{
@@ -23,19 +242,129 @@ void UAbilityStateTagHandler::BeginPlay()
 	OwnersASC = GetOwner()->FindComponentByClass<UAbilitySystemComponent>();
 	if (OwnersASC)
 	{
+		StateCheckContext.Owner = GetOwner();
+		StateCheckContext.AbilitySystem = OwnersASC;
+		StateCheckContext.Character = Cast<ACharacter>(GetOwner());
+
+		// Owning client checks are gated on the controller at evaluation, it usually changes after BeginPlay
+		bOwnerLocallyControlled = IsOwnerLocallyControlled();
+		if (APawn* OwnerPawn = Cast<APawn>(GetOwner()))
+		{
+			OwnerPawn->ReceiveControllerChangedDelegate.AddDynamic(this, &UAbilityStateTagHandler::OnOwnerControllerChanged);
+		}
+
 		// Loop through each state check class and instantiate it
 		for (TSubclassOf<UAbilityStateCheck_Base> StateCheckClass : AbilityStateTag->StateChecks)
 		{
 			if (StateCheckClass) // Ensure the class is valid before trying to create an instance
 			{
-				// Create an instance of the class dynamically
-				if (UAbilityStateCheck_Base* NewStateCheck = NewObject<UAbilityStateCheck_Base>(this, StateCheckClass))
+				// Create an instance of the class dynamically, unless it doesn't run on this machine
+				UAbilityStateCheck_Base* StateCheckCDO = StateCheckClass->GetDefaultObject<UAbilityStateCheck_Base>();
+				if (!ShouldRunStateCheckLocally(StateCheckCDO))
+				{
+					continue;
+				}
+
+				// Stateless checks share one instance per world, saving a UObject per actor for GC to trace. Only asked for when
+				// it will be used, the subsystem creates the shared instance on first request.
+				UAbilityStateCheck_Base* SharedStateCheck = nullptr;
+				if (GAbilityStateCheckShareStateless && StateCheckCDO->IsStateless())
+				{
+					UAbilityStateCheckSubsystem* SharedStateChecks = GetWorld()->GetSubsystem<UAbilityStateCheckSubsystem>();
+					SharedStateCheck = SharedStateChecks ? SharedStateChecks->GetSharedStateCheck(StateCheckClass) : nullptr;
+				}
+				AddStateCheckInstance(StateCheckCDO, SharedStateCheck);
+			}
+		}
+
+		// Checks authored in the asset, stateless ones are already shared by every actor using it
+		for (UAbilityStateCheck_Base* InlineStateCheck : AbilityStateTag->InlineStateChecks)
+		{
+			if (InlineStateCheck && ShouldRunStateCheckLocally(InlineStateCheck))
+			{
+				AddStateCheckInstance(InlineStateCheck, InlineStateCheck);
+			}
+		}
+
+		// Higher priority checks are evaluated first
+		AbilityStateCheckInstances.StableSort([](const UAbilityStateCheck_Base& A, const UAbilityStateCheck_Base& B)
+		{
+			return A.GetPriority() > B.GetPriority();
+		});
+
+		// Every check starts dirty so event-driven checks get their initial evaluation on the first tick
+		DirtyStateChecks.Init(true, AbilityStateCheckInstances.Num());
+		NextEvaluationTimes.Init(0.0, AbilityStateCheckInstances.Num());
+		StateCheckResults.Init(false, AbilityStateCheckInstances.Num());
+		StateCheckScratch.SetNum(AbilityStateCheckInstances.Num());
+		StateCheckStability.SetNum(AbilityStateCheckInstances.Num());
+
+		if (bUseWorldScheduler)
+		{
+			Scheduler = GetWorld()->GetSubsystem<UAbilityStateCheckSubsystem>();
+			if (Scheduler)
+			{
+				for (int32 CheckIndex = 0; CheckIndex < AbilityStateCheckInstances.Num(); ++CheckIndex)
 				{
-					AbilityStateCheckInstances.Add(NewStateCheck); // Store the new instance
-					UE_LOG(LogTemp, Log, TEXT("Created and added AbilityStateCheck instance: %s"), *StateCheckClass->GetName());
+					// Checks without tags have nothing to apply, keep an invalid id so indices still line up
+					UAbilityStateCheck_Base* StateCheckInstance = AbilityStateCheckInstances[CheckIndex];
+					ScheduledEntryIds.Add(StateCheckInstance->TagsToAdd.IsEmpty()
+						? FAbilityStateCheckEntryId()
+						: Scheduler->RegisterStateCheck(this, CheckIndex, StateCheckInstance, StateCheckContext, StateCheckScratch[CheckIndex]));
 				}
+
+				// The scheduler evaluates the checks, this component doesn't need to tick
+				SetComponentTickEnabled(false);
+			}
+			else
+			{
+				UE_LOG(LogTemp, Warning, TEXT("No state check scheduler in this world, %s falls back to ticking."), *GetName());
 			}
 		}
+
+		for (int32 CheckIndex = 0; CheckIndex < AbilityStateCheckInstances.Num(); ++CheckIndex)
+		{
+			if (AbilityStateCheckInstances[CheckIndex]->IsEventDriven())
+			{
+				BindStateCheckDependencies(CheckIndex);
+			}
+			else
+			{
+				++NumEveryFrameStateChecks;
+			}
+
+			if (AbilityStateCheckInstances[CheckIndex]->IgnoresLOD())
+			{
+				++NumLODExemptChecks;
+			}
+		}
+
+		// Re-score the owner periodically, the first update is staggered so handlers spawned together don't all update on the same frame
+		if (Significance && NumLODExemptChecks < AbilityStateCheckInstances.Num())
+		{
+			const float UpdateInterval = FMath::Max(Significance->GetUpdateInterval(), 0.01f);
+			GetWorld()->GetTimerManager().SetTimer(SignificanceTimerHandle, this, &UAbilityStateTagHandler::UpdateSignificance,
+				UpdateInterval, true, FMath::FRandRange(0.f, UpdateInterval));
+		}
+
+		// Bind once for all checks that depend on the movement mode
+		if (MovementModeDependentChecks.Num() > 0)
+		{
+			if (ACharacter* OwnerCharacter = Cast<ACharacter>(GetOwner()))
+			{
+				OwnerCharacter->MovementModeChangedDelegate.AddDynamic(this, &UAbilityStateTagHandler::OnOwnerMovementModeChanged);
+			}
+			else
+			{
+				UE_LOG(LogTemp, Warning, TEXT("State checks depend on movement mode but %s is not a character!"), *GetOwner()->GetName());
+			}
+		}
+
+		// Tag bits may have been received before BeginPlay
+		if (UsesCompactTagReplication() && !GetOwner()->HasAuthority())
+		{
+			ApplyReplicatedStateTagBits();
+		}
 	}
 	else
 	{
@@ -45,10 +374,72 @@ void UAbilityStateTagHandler::BeginPlay()
 	}
 }
 
+void UAbilityStateTagHandler::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (StateCheckLoadHandle)
+	{
+		StateCheckLoadHandle->CancelHandle();
+		StateCheckLoadHandle.Reset();
+	}
+
+	UnbindStateCheckDependencies();
+
+	if (APawn* OwnerPawn = Cast<APawn>(GetOwner()))
+	{
+		OwnerPawn->ReceiveControllerChangedDelegate.RemoveDynamic(this, &UAbilityStateTagHandler::OnOwnerControllerChanged);
+	}
+
+	if (UWorld* World = GetWorld())
+	{
+		World->GetTimerManager().ClearTimer(SignificanceTimerHandle);
+		for (FAbilityStateCheckStability& Stability : StateCheckStability)
+		{
+			World->GetTimerManager().ClearTimer(Stability.RetryTimerHandle);
+		}
+	}
+	AbilityStateTagHandlerLOD::TrackTier(LODTier, -1);
+	LODTier = EAbilityStateCheckLODTier::Full;
+
+	for (const UAbilityStateCheck_Base* StateCheckInstance : AbilityStateCheckInstances)
+	{
+		if (StateCheckInstance && StateCheckInstance->GetOuter() == this)
+		{
+			DEC_DWORD_STAT(STAT_AbilityStateTagHandler_InstancedChecks);
+		}
+		else if (StateCheckInstance)
+		{
+			DEC_DWORD_STAT(STAT_AbilityStateTagHandler_SharedChecks);
+		}
+	}
+	LODInterval = 0.f;
+
+	if (Scheduler)
+	{
+		for (const FAbilityStateCheckEntryId& EntryId : ScheduledEntryIds)
+		{
+			Scheduler->UnregisterStateCheck(EntryId);
+		}
+		ScheduledEntryIds.Reset();
+		Scheduler = nullptr;
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UAbilityStateTagHandler::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+	DOREPLIFETIME_WITH_PARAMS_FAST(UAbilityStateTagHandler, ReplicatedStateTagBits, Params);
+}
+
 void UAbilityStateTagHandler::TickComponent(float DeltaTime, ELevelTick TickType,
                                             FActorComponentTickFunction* ThisTickFunction)
 {
 	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+	SCOPE_CYCLE_COUNTER(STAT_AbilityStateTagHandler_Tick);
 
 	// Early return if Ability System Component is not found
 	if (!OwnersASC)
@@ -57,51 +448,568 @@ void UAbilityStateTagHandler::TickComponent(float DeltaTime, ELevelTick TickType
 		return;
 	}
 
+	const double Now = GetWorld()->GetTimeSeconds();
+	const bool bSuspended = LODTier == EAbilityStateCheckLODTier::Suspended;
+
 	// Loop through each AbilityStateCheck instance
-	for (UAbilityStateCheck_Base* StateCheckInstance : AbilityStateCheckInstances)
+	for (int32 CheckIndex = 0; CheckIndex < AbilityStateCheckInstances.Num(); ++CheckIndex)
 	{
-		if (StateCheckInstance) // Ensure the instance is valid
+		UAbilityStateCheck_Base* StateCheckInstance = AbilityStateCheckInstances[CheckIndex];
+		if (!StateCheckInstance) // Ensure the instance is valid
+		{
+			continue;
+		}
+
+		// Suspended checks keep their dirty flag and run as soon as the owner becomes significant again
+		const bool bAffectedByLOD = !StateCheckInstance->IgnoresLOD();
+		if (bSuspended && bAffectedByLOD)
+		{
+			continue;
+		}
+
+		// Event-driven checks are only re-run when something they depend on has changed,
+		// polled checks when their evaluation interval has elapsed
+		const bool bDue = DirtyStateChecks[CheckIndex]
+			|| (!StateCheckInstance->IsEventDriven() && Now >= NextEvaluationTimes[CheckIndex]);
+
+		if (bDue)
 		{
-			// Perform logic on the state check instance
-			if (StateCheckInstance->TagsToAdd.IsEmpty())
+			DirtyStateChecks[CheckIndex] = false;
+			const float Interval = StateCheckInstance->GetEvaluationInterval();
+			NextEvaluationTimes[CheckIndex] = Now + (bAffectedByLOD ? FMath::Max(Interval, LODInterval) : Interval);
+			EvaluateStateCheck(CheckIndex);
+		}
+	}
+
+	// Apply every change from this tick at once
+	FlushStateTags();
+
+	// Nothing left to poll, sleep until a dependency marks a check dirty again or the owner becomes significant
+	if (NumEveryFrameStateChecks == 0 || (bSuspended && NumLODExemptChecks == 0))
+	{
+		SetComponentTickEnabled(false);
+	}
+}
+
+bool UAbilityStateTagHandler::ShouldRunStateCheckLocally(const UAbilityStateCheck_Base* StateCheckCDO) const
+{
+	const AActor* Owner = GetOwner();
+
+	// With compact tag replication, replicated checks only run on the authority
+	if (UsesCompactTagReplication() && !Owner->HasAuthority() && StateCheckCDO->ShouldReplicate())
+	{
+		return false;
+	}
+
+	switch (StateCheckCDO->GetNetExecution())
+	{
+	case EAbilityStateCheckNetExecution::AuthorityOnly:
+		return Owner->HasAuthority();
+	case EAbilityStateCheckNetExecution::OwningClientOnly:
+		// Whether this machine controls the owner is only checked when evaluating, as it changes with possession
+		return GetNetMode() != NM_DedicatedServer;
+	default:
+		return true;
+	}
+}
+
+bool UAbilityStateTagHandler::IsOwnerLocallyControlled() const
+{
+	// A listen server is the owning client of the pawns it controls, a dedicated server never is
+	if (GetNetMode() == NM_DedicatedServer)
+	{
+		return false;
+	}
+
+	const AActor* Owner = GetOwner();
+	if (const APawn* OwnerPawn = Cast<APawn>(Owner))
+	{
+		return OwnerPawn->IsLocallyControlled();
+	}
+	return Owner->HasLocalNetOwner();
+}
+
+void UAbilityStateTagHandler::OnOwnerControllerChanged(APawn* Pawn, AController* OldController, AController* NewController)
+{
+	const bool bWasLocallyControlled = bOwnerLocallyControlled;
+	bOwnerLocallyControlled = IsOwnerLocallyControlled();
+	if (bOwnerLocallyControlled == bWasLocallyControlled)
+	{
+		return;
+	}
+
+	// Run the owning client checks again, or drop their tags now that they're gated off
+	for (int32 CheckIndex = 0; CheckIndex < AbilityStateCheckInstances.Num(); ++CheckIndex)
+	{
+		if (AbilityStateCheckInstances[CheckIndex]->GetNetExecution() == EAbilityStateCheckNetExecution::OwningClientOnly)
+		{
+			MarkStateCheckDirtyAt(CheckIndex);
+		}
+	}
+}
+
+void UAbilityStateTagHandler::AddStateCheckInstance(UAbilityStateCheck_Base* Template, UAbilityStateCheck_Base* SharedInstance)
+{
+	if (GAbilityStateCheckShareStateless && SharedInstance && Template->IsStateless())
+	{
+		AbilityStateCheckInstances.Add(SharedInstance);
+		INC_DWORD_STAT(STAT_AbilityStateTagHandler_SharedChecks);
+	}
+	else if (UAbilityStateCheck_Base* NewStateCheck = NewObject<UAbilityStateCheck_Base>(this, Template->GetClass(), NAME_None, RF_NoFlags, Template))
+	{
+		AbilityStateCheckInstances.Add(NewStateCheck); // Store the new instance
+		INC_DWORD_STAT(STAT_AbilityStateTagHandler_InstancedChecks);
+		UE_LOG(LogTemp, Log, TEXT("Created and added AbilityStateCheck instance: %s"), *Template->GetClass()->GetName());
+	}
+}
+
+void UAbilityStateTagHandler::EvaluateStateCheck(int32 CheckIndex)
+{
+	UAbilityStateCheck_Base* StateCheckInstance = AbilityStateCheckInstances[CheckIndex];
+
+	// Perform logic on the state check instance
+	if (StateCheckInstance->TagsToAdd.IsEmpty())
+	{
+		UE_LOG(LogTemp, Log, TEXT("No gameplay tags specified in state check object: %s"), *StateCheckInstance->GetName());
+		return;
+	}
+
+	// Not worth running while gated off, ApplyStateCheckResult fails it anyway
+	if (!bOwnerLocallyControlled && StateCheckInstance->GetNetExecution() == EAbilityStateCheckNetExecution::OwningClientOnly)
+	{
+		ApplyStateCheckResult(CheckIndex, false);
+		return;
+	}
+
+	// Run the check and update the tags accordingly
+	ApplyStateCheckResult(CheckIndex, StateCheckInstance->EvaluateTransition(StateCheckContext, StateCheckScratch[CheckIndex], StateCheckResults[CheckIndex]));
+}
+
+void UAbilityStateTagHandler::ApplyStateCheckResult(int32 CheckIndex, bool bPassed)
+{
+	if (!OwnersASC || !AbilityStateCheckInstances.IsValidIndex(CheckIndex))
+	{
+		return;
+	}
+
+	DirtyStateChecks[CheckIndex] = false;
+
+	// Owning client checks only pass on the machine controlling the owner
+	const UAbilityStateCheck_Base* StateCheckInstance = AbilityStateCheckInstances[CheckIndex];
+	if (!bOwnerLocallyControlled && StateCheckInstance->GetNetExecution() == EAbilityStateCheckNetExecution::OwningClientOnly)
+	{
+		bPassed = false;
+	}
+
+	// Debounce results at the edge of the condition
+	if (StateCheckInstance->HasStabilitySettings())
+	{
+		bPassed = StabilizeStateCheckResult(CheckIndex, bPassed);
+	}
+
+	// Nothing to do if the result hasn't changed since the last evaluation
+	if (StateCheckResults[CheckIndex] == bPassed)
+	{
+		return;
+	}
+	StateCheckResults[CheckIndex] = bPassed;
+	AbilityStateTagHandlerTransitions::Record();
+
+	// Cache the tags container to optimize calls
+	const FGameplayTagContainer& TagsToAdd = StateCheckInstance->TagsToAdd;
+
+	// Count how many passing checks want each tag, the tags themselves are only touched in FlushStateTags
+	TMap<FGameplayTag, int32>& TagCounts = StateCheckInstance->bShouldReplicate ? ReplicatedStateTagCounts : LocalStateTagCounts;
+	const int32 CountDelta = bPassed ? 1 : -1;
+	for (const FGameplayTag& Tag : TagsToAdd)
+	{
+		int32& Count = TagCounts.FindOrAdd(Tag);
+		Count += CountDelta;
+		if (Count <= 0)
+		{
+			TagCounts.Remove(Tag);
+		}
+	}
+
+	bStateTagsDirty = true;
+}
+
+bool UAbilityStateTagHandler::StabilizeStateCheckResult(int32 CheckIndex, bool bPassed)
+{
+	const bool bApplied = StateCheckResults[CheckIndex];
+	FAbilityStateCheckStability& Stability = StateCheckStability[CheckIndex];
+	if (bPassed == bApplied)
+	{
+		// The condition went back before the change was allowed
+		Stability.PendingSince = -1.0;
+		return bApplied;
+	}
+
+	const double Now = GetWorld()->GetTimeSeconds();
+	if (Stability.PendingSince < 0.0)
+	{
+		Stability.PendingSince = Now;
+	}
+
+	const UAbilityStateCheck_Base* StateCheckInstance = AbilityStateCheckInstances[CheckIndex];
+	const float Delay = bPassed ? StateCheckInstance->GetRisingDelay() : StateCheckInstance->GetFallingDelay();
+	const double AllowedTime = FMath::Max(Stability.PendingSince + Delay, Stability.LastChangeTime + StateCheckInstance->GetMinHoldTime());
+	if (Now >= AllowedTime)
+	{
+		Stability.PendingSince = -1.0;
+		Stability.LastChangeTime = Now;
+		return bPassed;
+	}
+
+	INC_DWORD_STAT(STAT_AbilityStateTagHandler_TransitionsHeldBack);
+
+	// Polled checks run again anyway, event-driven ones need a nudge once the change is allowed. A timer rather than the tick,
+	// so nothing runs in between
+	FTimerManager& TimerManager = GetWorld()->GetTimerManager();
+	if (StateCheckInstance->IsEventDriven() && !TimerManager.IsTimerActive(Stability.RetryTimerHandle))
+	{
+		TimerManager.SetTimer(Stability.RetryTimerHandle, FTimerDelegate::CreateUObject(this, &UAbilityStateTagHandler::MarkStateCheckDirtyAt, CheckIndex),
+			static_cast<float>(AllowedTime - Now), false);
+	}
+	return bApplied;
+}
+
+void UAbilityStateTagHandler::FlushStateTags()
+{
+	if (!bStateTagsDirty || !OwnersASC)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_AbilityStateTagHandler_FlushTags);
+	bStateTagsDirty = false;
+
+	FlushStateTagSet(LocalStateTagCounts, AppliedLocalStateTags, false);
+
+	// With compact tag replication, the tags are applied locally and sent through the tag bits instead
+	const bool bCompactReplication = UsesCompactTagReplication();
+	FlushStateTagSet(ReplicatedStateTagCounts, AppliedReplicatedStateTags, !bCompactReplication);
+	if (bCompactReplication && GetOwner()->HasAuthority())
+	{
+		UpdateReplicatedStateTagBits();
+	}
+}
+
+void UAbilityStateTagHandler::FlushStateTagSet(const TMap<FGameplayTag, int32>& TagCounts, FGameplayTagContainer& AppliedTags, bool bShouldReplicate)
+{
+	// Every tag wanted by at least one passing check
+	FGameplayTagContainer WantedTags;
+	for (const TPair<FGameplayTag, int32>& TagCount : TagCounts)
+	{
+		WantedTags.AddTagFast(TagCount.Key);
+	}
+
+	ApplyStateTagDiff(WantedTags, AppliedTags, bShouldReplicate);
+}
+
+void UAbilityStateTagHandler::ApplyStateTagDiff(const FGameplayTagContainer& WantedTags, FGameplayTagContainer& AppliedTags, bool bShouldReplicate)
+{
+	FGameplayTagContainer TagsToAdd;
+	FGameplayTagContainer TagsToRemove;
+
+	// Diff the wanted tags against the ones applied by the previous flush
+	for (const FGameplayTag& Tag : WantedTags)
+	{
+		if (!AppliedTags.HasTagExact(Tag))
+		{
+			TagsToAdd.AddTagFast(Tag);
+		}
+	}
+	for (const FGameplayTag& Tag : AppliedTags)
+	{
+		if (!WantedTags.HasTagExact(Tag))
+		{
+			TagsToRemove.AddTagFast(Tag);
+		}
+	}
+
+	// One batched call each way, so listeners are only notified about actual changes
+	if (!TagsToRemove.IsEmpty())
+	{
+		OwnersASC->RemoveLooseGameplayTags(TagsToRemove);
+		if (bShouldReplicate)
+		{
+			OwnersASC->RemoveReplicatedLooseGameplayTags(TagsToRemove);
+			INC_DWORD_STAT_BY(STAT_AbilityStateTagHandler_ReplicatedLooseTagChanges, TagsToRemove.Num());
+		}
+		AppliedTags.RemoveTags(TagsToRemove);
+		INC_DWORD_STAT_BY(STAT_AbilityStateTagHandler_TagsRemoved, TagsToRemove.Num());
+	}
+
+	if (!TagsToAdd.IsEmpty())
+	{
+		OwnersASC->AddLooseGameplayTags(TagsToAdd);
+		if (bShouldReplicate)
+		{
+			OwnersASC->AddReplicatedLooseGameplayTags(TagsToAdd);
+			INC_DWORD_STAT_BY(STAT_AbilityStateTagHandler_ReplicatedLooseTagChanges, TagsToAdd.Num());
+		}
+		AppliedTags.AppendTags(TagsToAdd);
+		INC_DWORD_STAT_BY(STAT_AbilityStateTagHandler_TagsAdded, TagsToAdd.Num());
+	}
+}
+
+bool UAbilityStateTagHandler::UsesCompactTagReplication() const
+{
+	return bReplicateStateTagBits && AbilityStateTag != nullptr;
+}
+
+void UAbilityStateTagHandler::UpdateReplicatedStateTagBits()
+{
+	SCOPE_CYCLE_COUNTER(STAT_AbilityStateTagHandler_CompactReplication);
+
+	const TArray<FGameplayTag>& TagTable = AbilityStateTag->GetReplicatedTagTable();
+
+	FAbilityStateTagBits NewBits;
+	NewBits.Bits.Init(false, TagTable.Num());
+	for (int32 TagIndex = 0; TagIndex < TagTable.Num(); ++TagIndex)
+	{
+		if (AppliedReplicatedStateTags.HasTagExact(TagTable[TagIndex]))
+		{
+			NewBits.Bits[TagIndex] = true;
+		}
+	}
+
+	// Only a change of bits is sent. With push model replication, a stable handler isn't even compared
+	if (!(NewBits == ReplicatedStateTagBits))
+	{
+		ReplicatedStateTagBits = MoveTemp(NewBits);
+		MARK_PROPERTY_DIRTY_FROM_NAME(UAbilityStateTagHandler, ReplicatedStateTagBits, this);
+		INC_DWORD_STAT(STAT_AbilityStateTagHandler_CompactBitUpdates);
+	}
+}
+
+void UAbilityStateTagHandler::ApplyReplicatedStateTagBits()
+{
+	if (!OwnersASC || !UsesCompactTagReplication())
+	{
+		return;
+	}
+
+	const TArray<FGameplayTag>& TagTable = AbilityStateTag->GetReplicatedTagTable();
+	if (ReplicatedStateTagBits.Bits.Num() != TagTable.Num())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Replicated state tag bits don't match the tag table of %s (%d bits, %d tags)!"),
+			*AbilityStateTag->GetName(), ReplicatedStateTagBits.Bits.Num(), TagTable.Num());
+	}
+
+	FGameplayTagContainer ServerTags;
+	const int32 NumBits = FMath::Min(ReplicatedStateTagBits.Bits.Num(), TagTable.Num());
+	for (int32 TagIndex = 0; TagIndex < NumBits; ++TagIndex)
+	{
+		if (ReplicatedStateTagBits.Bits[TagIndex])
+		{
+			ServerTags.AddTagFast(TagTable[TagIndex]);
+		}
+	}
+
+	// The server's tags are applied locally, they are already replicated through the bits
+	ApplyStateTagDiff(ServerTags, AppliedReplicatedStateTags, false);
+}
+
+void UAbilityStateTagHandler::OnRep_ReplicatedStateTagBits()
+{
+	ApplyReplicatedStateTagBits();
+}
+
+void UAbilityStateTagHandler::MarkStateCheckDirty(const UAbilityStateCheck_Base* StateCheck)
+{
+	const int32 CheckIndex = AbilityStateCheckInstances.IndexOfByKey(StateCheck);
+	if (CheckIndex != INDEX_NONE)
+	{
+		MarkStateCheckDirtyAt(CheckIndex);
+	}
+}
+
+void UAbilityStateTagHandler::MarkAllStateChecksDirty()
+{
+	for (int32 CheckIndex = 0; CheckIndex < AbilityStateCheckInstances.Num(); ++CheckIndex)
+	{
+		MarkStateCheckDirtyAt(CheckIndex);
+	}
+}
+
+void UAbilityStateTagHandler::MarkStateCheckDirtyAt(int32 CheckIndex)
+{
+	if (!OwnersASC || !DirtyStateChecks.IsValidIndex(CheckIndex))
+	{
+		return;
+	}
+
+	DirtyStateChecks[CheckIndex] = true;
+
+	if (Scheduler)
+	{
+		Scheduler->MarkStateCheckDirty(ScheduledEntryIds[CheckIndex]);
+		return;
+	}
+
+	// A suspended check stays dirty until the owner becomes significant again, no need to wake up for it
+	if (LODTier == EAbilityStateCheckLODTier::Suspended && !AbilityStateCheckInstances[CheckIndex]->IgnoresLOD())
+	{
+		return;
+	}
+
+	// Several dependencies can change in the same frame, they are all coalesced into the next tick
+	if (!IsComponentTickEnabled())
+	{
+		SetComponentTickEnabled(true);
+	}
+}
+
+void UAbilityStateTagHandler::UpdateSignificance()
+{
+	if (!Significance || !OwnersASC)
+	{
+		return;
+	}
+
+	EAbilityStateCheckLODTier NewTier = EAbilityStateCheckLODTier::Full;
+	if (UAbilityStateCheckSignificance::IsLODEnabled())
+	{
+		// Any handler can gather the view locations, the subsystem caches them for everyone for the frame
+		UAbilityStateCheckSubsystem* ViewSource = Scheduler ? Scheduler : GetWorld()->GetSubsystem<UAbilityStateCheckSubsystem>();
+		if (ViewSource)
+		{
+			NewTier = Significance->GetTier(Significance->CalculateSignificance(GetOwner(), ViewSource->GetViewLocations()));
+		}
+	}
+
+	SetLODTier(NewTier);
+}
+
+void UAbilityStateTagHandler::SetLODTier(EAbilityStateCheckLODTier NewTier)
+{
+	if (NewTier == LODTier)
+	{
+		return;
+	}
+
+	INC_DWORD_STAT(STAT_AbilityStateTagHandler_LODTransitions);
+	AbilityStateTagHandlerLOD::TrackTier(LODTier, -1);
+	AbilityStateTagHandlerLOD::TrackTier(NewTier, 1);
+
+	const bool bWasSuspended = LODTier == EAbilityStateCheckLODTier::Suspended;
+	const bool bSuspended = NewTier == EAbilityStateCheckLODTier::Suspended;
+	LODTier = NewTier;
+	LODInterval = Significance ? Significance->GetTierInterval(NewTier) : 0.f;
+
+	if (Scheduler)
+	{
+		for (int32 CheckIndex = 0; CheckIndex < AbilityStateCheckInstances.Num(); ++CheckIndex)
+		{
+			const FAbilityStateCheckEntryId& EntryId = ScheduledEntryIds[CheckIndex];
+			if (EntryId.EntryIndex != INDEX_NONE && !AbilityStateCheckInstances[CheckIndex]->IgnoresLOD())
 			{
-				UE_LOG(LogTemp, Log, TEXT("No gameplay tags specified in state check object: %s"), *StateCheckInstance->GetName());
+				Scheduler->SetStateCheckLOD(EntryId, LODInterval, bSuspended);
 			}
-			else
-			{
-				// Cache the tags container to optimize calls
-				const FGameplayTagContainer& TagsToAdd = StateCheckInstance->TagsToAdd;
+		}
+		return;
+	}
 
-				// Determine whether to replicate
-				bool ShouldReplicate = StateCheckInstance->bShouldReplicate;
+	// Catch up on anything that became due or dirty while suspended, the tick goes back to sleep if there is nothing to do
+	if (bWasSuspended && !IsComponentTickEnabled())
+	{
+		SetComponentTickEnabled(true);
+	}
+}
 
-				// Run the check and update the tags accordingly
-				if (StateCheckInstance->Run(GetOwner()))
-				{
-					// Add missing tags if the condition is true
-					UAbilitySystemBlueprintLibrary::AddLooseGameplayTags(GetOwner(), GetMissingTags(TagsToAdd.GetGameplayTagArray()), ShouldReplicate);
-				}
-				else
-				{
-					// Remove the tags if the condition is false
-					UAbilitySystemBlueprintLibrary::RemoveLooseGameplayTags(GetOwner(), TagsToAdd, ShouldReplicate);
-				}
-			}
+void UAbilityStateTagHandler::BindStateCheckDependencies(int32 CheckIndex)
+{
+	const UAbilityStateCheck_Base* StateCheckInstance = AbilityStateCheckInstances[CheckIndex];
+
+	for (const FGameplayTag& Tag : StateCheckInstance->DependencyTags)
+	{
+		FDelegateHandle Handle = OwnersASC->RegisterGameplayTagEvent(Tag, EGameplayTagEventType::NewOrRemoved)
+			.AddUObject(this, &UAbilityStateTagHandler::OnDependencyTagChanged, CheckIndex);
+		TagDependencyHandles.Emplace(Tag, Handle);
+	}
+
+	for (const FGameplayAttribute& Attribute : StateCheckInstance->DependencyAttributes)
+	{
+		if (Attribute.IsValid())
+		{
+			FDelegateHandle Handle = OwnersASC->GetGameplayAttributeValueChangeDelegate(Attribute)
+				.AddUObject(this, &UAbilityStateTagHandler::OnDependencyAttributeChanged, CheckIndex);
+			AttributeDependencyHandles.Emplace(Attribute, Handle);
 		}
 	}
+
+	if (StateCheckInstance->bDependsOnMovementMode)
+	{
+		MovementModeDependentChecks.Add(CheckIndex);
+	}
+
+	if (StateCheckInstance->TimerInterval > 0.f)
+	{
+		FTimerHandle& TimerHandle = DependencyTimerHandles.AddDefaulted_GetRef();
+		GetWorld()->GetTimerManager().SetTimer(TimerHandle,
+			FTimerDelegate::CreateUObject(this, &UAbilityStateTagHandler::MarkStateCheckDirtyAt, CheckIndex),
+			StateCheckInstance->TimerInterval, true);
+	}
+
+	if (StateCheckInstance->DependencyTags.IsEmpty() && StateCheckInstance->DependencyAttributes.IsEmpty()
+		&& !StateCheckInstance->bDependsOnMovementMode && StateCheckInstance->TimerInterval <= 0.f)
+	{
+		UE_LOG(LogTemp, Log, TEXT("Event-driven state check %s has no dependencies, it will only run when marked dirty."), *StateCheckInstance->GetName());
+	}
 }
 
-FGameplayTagContainer UAbilityStateTagHandler::GetMissingTags(TArray<FGameplayTag> Tags)
+void UAbilityStateTagHandler::UnbindStateCheckDependencies()
 {
-	FGameplayTagContainer NeedToAddTags;
+	if (OwnersASC)
+	{
+		for (const TPair<FGameplayTag, FDelegateHandle>& TagHandle : TagDependencyHandles)
+		{
+			OwnersASC->UnregisterGameplayTagEvent(TagHandle.Value, TagHandle.Key, EGameplayTagEventType::NewOrRemoved);
+		}
 
-	// Loop through each tag and check if it exists on the AbilitySystemComponent
-	for (const FGameplayTag& tag : Tags)
+		for (const TPair<FGameplayAttribute, FDelegateHandle>& AttributeHandle : AttributeDependencyHandles)
+		{
+			OwnersASC->GetGameplayAttributeValueChangeDelegate(AttributeHandle.Key).Remove(AttributeHandle.Value);
+		}
+	}
+	TagDependencyHandles.Reset();
+	AttributeDependencyHandles.Reset();
+
+	if (MovementModeDependentChecks.Num() > 0)
 	{
-		if (OwnersASC->GetGameplayTagCount(tag) == 0)
+		if (ACharacter* OwnerCharacter = Cast<ACharacter>(GetOwner()))
 		{
-			NeedToAddTags.AddTag(tag);
+			OwnerCharacter->MovementModeChangedDelegate.RemoveDynamic(this, &UAbilityStateTagHandler::OnOwnerMovementModeChanged);
 		}
+		MovementModeDependentChecks.Reset();
+	}
+
+	if (UWorld* World = GetWorld())
+	{
+		for (FTimerHandle& TimerHandle : DependencyTimerHandles)
+		{
+			World->GetTimerManager().ClearTimer(TimerHandle);
+		}
+	}
+	DependencyTimerHandles.Reset();
+}
+
+void UAbilityStateTagHandler::OnDependencyTagChanged(const FGameplayTag Tag, int32 NewCount, int32 CheckIndex)
+{
+	MarkStateCheckDirtyAt(CheckIndex);
+}
+
+void UAbilityStateTagHandler::OnDependencyAttributeChanged(const FOnAttributeChangeData& ChangeData, int32 CheckIndex)
+{
+	MarkStateCheckDirtyAt(CheckIndex);
+}
+
+void UAbilityStateTagHandler::OnOwnerMovementModeChanged(ACharacter* Character, EMovementMode PrevMovementMode, uint8 PreviousCustomMode)
+{
+	for (const int32 CheckIndex : MovementModeDependentChecks)
+	{
+		MarkStateCheckDirtyAt(CheckIndex);
 	}
-	return NeedToAddTags;
 }
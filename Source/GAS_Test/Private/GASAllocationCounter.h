@@ -0,0 +1,174 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/MemoryBase.h"
+#include "HAL/PlatformTLS.h"
+#include <atomic>
+
+#if !UE_BUILD_SHIPPING
+
+class UAbilityInputHandler;
+
+/**
+ * Wraps GMalloc to count the heap allocations of the thread an FGASScopedAllocationCounter is alive on.
+ * 
+ * Installed the first time a counter is created and never removed nor freed: every thread keeps allocating through GMalloc,
+ * and any of them may have loaded the pointer just before it changed. Every call is forwarded to the wrapped allocator.
+ */
+class FGASAllocationCountingMalloc final : public FMalloc
+{
+public:
+	static FGASAllocationCountingMalloc& Get()
+	{
+		static FGASAllocationCountingMalloc* Instance = []()
+		{
+			check(IsInGameThread());
+			FGASAllocationCountingMalloc* CountingMalloc = new FGASAllocationCountingMalloc(GMalloc);
+			FPlatformAtomics::InterlockedExchangePtr(reinterpret_cast<void**>(&GMalloc), CountingMalloc);
+			return CountingMalloc;
+		}();
+		return *Instance;
+	}
+
+	/** Starts counting the allocations of the calling thread, one thread at a time. */
+	void BeginCounting()
+	{
+		const uint32 PreviousThreadId = CountedThreadId.exchange(FPlatformTLS::GetCurrentThreadId());
+		check(PreviousThreadId == 0);
+	}
+
+	void EndCounting()
+	{
+		CountedThreadId.store(0);
+	}
+
+	/** Allocations and reallocations counted so far, over every counting scope. */
+	uint64 GetNumAllocations() const { return NumAllocations.load(std::memory_order_relaxed); }
+
+	virtual void* Malloc(SIZE_T Count, uint32 Alignment) override
+	{
+		CountAllocation();
+		return InnerMalloc->Malloc(Count, Alignment);
+	}
+
+	virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override
+	{
+		CountAllocation();
+		return InnerMalloc->Realloc(Original, Count, Alignment);
+	}
+
+	virtual void Free(void* Original) override
+	{
+		InnerMalloc->Free(Original);
+	}
+
+	virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override
+	{
+		return InnerMalloc->QuantizeSize(Count, Alignment);
+	}
+
+	virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override
+	{
+		return InnerMalloc->GetAllocationSize(Original, SizeOut);
+	}
+
+	virtual void Trim(bool bTrimThreadCaches) override
+	{
+		InnerMalloc->Trim(bTrimThreadCaches);
+	}
+
+	virtual void SetupTLSCachesOnCurrentThread() override
+	{
+		InnerMalloc->SetupTLSCachesOnCurrentThread();
+	}
+
+	virtual void ClearAndDisableTLSCachesOnCurrentThread() override
+	{
+		InnerMalloc->ClearAndDisableTLSCachesOnCurrentThread();
+	}
+
+	virtual bool IsInternallyThreadSafe() const override
+	{
+		return InnerMalloc->IsInternallyThreadSafe();
+	}
+
+	virtual bool ValidateHeap() override
+	{
+		return InnerMalloc->ValidateHeap();
+	}
+
+	virtual void UpdateStats() override
+	{
+		InnerMalloc->UpdateStats();
+	}
+
+	virtual void GetAllocatorStats(FGenericMemoryStats& OutStats) override
+	{
+		InnerMalloc->GetAllocatorStats(OutStats);
+	}
+
+	virtual void DumpAllocatorStats(FOutputDevice& Ar) override
+	{
+		InnerMalloc->DumpAllocatorStats(Ar);
+	}
+
+	virtual const TCHAR* GetDescriptiveName() override
+	{
+		return InnerMalloc->GetDescriptiveName();
+	}
+
+private:
+	explicit FGASAllocationCountingMalloc(FMalloc* InInnerMalloc)
+		: InnerMalloc(InInnerMalloc)
+	{
+	}
+
+	void CountAllocation()
+	{
+		// Worker and render threads keep allocating, only the counted thread's allocations are of interest
+		if (FPlatformTLS::GetCurrentThreadId() == CountedThreadId.load(std::memory_order_relaxed))
+		{
+			NumAllocations.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	FMalloc* InnerMalloc = nullptr;
+	std::atomic<uint32> CountedThreadId = 0;
+	std::atomic<uint64> NumAllocations = 0;
+};
+
+/**
+ * Counts the heap allocations made on the current thread while in scope.
+ * 
+ * Development tool for the input and state tag benchmarks and tests, only ever create one at a time.
+ */
+class FGASScopedAllocationCounter
+{
+public:
+	FGASScopedAllocationCounter()
+		: CountingMalloc(FGASAllocationCountingMalloc::Get())
+	{
+		CountingMalloc.BeginCounting();
+		StartAllocations = CountingMalloc.GetNumAllocations();
+	}
+
+	~FGASScopedAllocationCounter()
+	{
+		CountingMalloc.EndCounting();
+	}
+
+	/** Number of allocations and reallocations made on this thread so far. */
+	uint64 GetNumAllocations() const { return CountingMalloc.GetNumAllocations() - StartAllocations; }
+
+private:
+	FGASAllocationCountingMalloc& CountingMalloc;
+	uint64 StartAllocations = 0;
+};
+
+/**
+ * Dispatches Count inputs through the handler, cycling through the bound tags of its input config, after a first pass
+ * so lazily built data isn't counted. Returns false if the config binds no tag, otherwise the allocations they made.
+ */
+bool GASDispatchInputBurst(UAbilityInputHandler& Handler, int32 Count, uint64& OutNumAllocations);
+
+#endif // !UE_BUILD_SHIPPING
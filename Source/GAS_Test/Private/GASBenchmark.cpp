@@ -0,0 +1,1077 @@
+﻿#include "AbilityInputHandler.h"
+#include "AbilityStateCheckSignificance.h"
+#include "AbilityStateTagHandler.h"
+#include "AbilitySystemComponent.h"
+#include "AbilitySystemGlobals.h"
+#include "GASAllocationCounter.h"
+#include "GASInputConfig.h"
+#include "GASInputRecording.h"
+#include "GameplayTagsManager.h"
+#include "InputAction.h"
+#include "Containers/Ticker.h"
+#include "Dom/JsonObject.h"
+#include "Engine/World.h"
+#include "GameFramework/GameModeBase.h"
+#include "GameFramework/Pawn.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformMemory.h"
+#include "Math/RandomStream.h"
+#include "Misc/App.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonSerializer.h"
+#include "Tests/GASTestPawn.h"
+#include "Tests/GASTestUtilities.h"
+#include "UObject/StrongObjectPtr.h"
+#include "UObject/UObjectArray.h"
+#include "UObject/UObjectIterator.h"
+
+#if !UE_BUILD_SHIPPING
+
+/**
+ * Spawns batches of pawns carrying UAbilityInputHandler and UAbilityStateTagHandler, drives synthetic input through the tags
+ * bound by their input config and records the cost of every frame, written as JSON once every batch has run.
+ * 
+ * Meant to be run headless to catch regressions and compare state check evaluation modes, e.g.
+ * UnrealEditor GAS_Test.uproject /Game/Maps/Benchmark -game -nullrhi -unattended -benchmark -ExecCmds="GAS.Benchmark Quit"
+ * 
+ * Compare=<cvar> runs every batch twice, with the console variable set to 0 then 1. CompareLOD is short for
+ * Compare=AbilityStateCheck.LOD.Enable, e.g. for 500 AI pawns spread past the significance distance of a pawn class
+ * using UAbilityStateCheckSignificance:
+ * -ExecCmds="GAS.Benchmark Pawn=/Game/AI/BP_AIPawn.BP_AIPawn_C Counts=500 Spacing=1000 CompareLOD Quit"
+ * and CompareSharing for Compare=AbilityStateCheck.ShareStatelessChecks, reporting the UObject count, a full GC and the
+ * memory used by each batch with and without shared stateless state checks.
+ * 
+ * The GAS_Test.Benchmark automation tests run it on native test pawns: Handlers fails over budget, for the CI, while
+ * CompactReplication, LOD and Sharing run CompareCompactReplication, CompareLOD and CompareSharing in a standalone world.
+ * GAS_Test.Benchmark.Combos times the combo matcher like GAS.Benchmark.Combos.
+ * 
+ * Replay=<file> replaces the synthetic input with a recording made by GAS.Input.Record, fed to every pawn from the first
+ * measured frame and looped, so runs of a real play session are comparable across builds, e.g.
+ * -ExecCmds="GAS.Benchmark Counts=200 Replay=Combat.gasinput Quit"
+ */
+class FGASBenchmarkRunner
+{
+public:
+	struct FSettings
+	{
+		TSubclassOf<APawn> PawnClass;
+		TArray<int32> PawnCounts;
+		int32 WarmupFrames = 60;
+		int32 MeasuredFrames = 300;
+		FString OutputPath;
+		bool bQuitWhenDone = false;
+		FString CompareVariableName;
+		double Spacing = 200.0;
+		FString ReplayPath;
+		FGASInputRecording Replay;
+
+		/** Called on every pawn before it finishes spawning, e.g. to give its handlers a config. */
+		TFunction<void(APawn&)> PreparePawn;
+	};
+
+	FGASBenchmarkRunner(UWorld* InWorld, FSettings&& InSettings)
+		: World(InWorld)
+		, Settings(MoveTemp(InSettings))
+	{
+		TickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FGASBenchmarkRunner::Tick));
+		PreActorTickHandle = FWorldDelegates::OnWorldPreActorTick.AddRaw(this, &FGASBenchmarkRunner::OnPreActorTick);
+		PostActorTickHandle = FWorldDelegates::OnWorldPostActorTick.AddRaw(this, &FGASBenchmarkRunner::OnPostActorTick);
+
+		LODEnableVariable = IConsoleManager::Get().FindConsoleVariable(TEXT("AbilityStateCheck.LOD.Enable"));
+		ShareStatelessVariable = IConsoleManager::Get().FindConsoleVariable(TEXT("AbilityStateCheck.ShareStatelessChecks"));
+		CompactReplicationVariable = IConsoleManager::Get().FindConsoleVariable(TEXT("AbilityStateCheck.CompactTagReplication"));
+		if (!Settings.CompareVariableName.IsEmpty())
+		{
+			CompareVariable = IConsoleManager::Get().FindConsoleVariable(*Settings.CompareVariableName);
+			InitialCompareValue = CompareVariable ? CompareVariable->GetString() : FString();
+		}
+		NumRuns = Settings.PawnCounts.Num() * GetNumPasses();
+	}
+
+	~FGASBenchmarkRunner()
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+		FWorldDelegates::OnWorldPreActorTick.Remove(PreActorTickHandle);
+		FWorldDelegates::OnWorldPostActorTick.Remove(PostActorTickHandle);
+		DestroyPawns();
+	}
+
+	bool IsDone() const { return bDone; }
+
+	/** Results of every batch run so far, as written to the report. */
+	const TArray<TSharedPtr<FJsonValue>>& GetBatches() const { return Batches; }
+
+private:
+	/** Cost of one measured frame. */
+	struct FFrameSample
+	{
+		double FrameMs = 0.0;
+		double ActorTickMs = 0.0;
+		double InputDispatchMs = 0.0;
+		uint64 InputAllocations = 0;
+		int32 TagChanges = 0;
+	};
+
+	struct FSpawnedPawn
+	{
+		TWeakObjectPtr<APawn> Pawn;
+		TWeakObjectPtr<UAbilityInputHandler> InputHandler;
+		TWeakObjectPtr<UAbilitySystemComponent> AbilitySystem;
+		FDelegateHandle TagChangedHandle;
+	};
+
+	bool Tick(float DeltaTime)
+	{
+		if (!World.IsValid())
+		{
+			UE_LOG(LogTemp, Error, TEXT("GAS.Benchmark: the world went away, aborting."));
+			Finish();
+			return false;
+		}
+
+		const double Now = FPlatformTime::Seconds();
+
+		// Each batch spawns its pawns, lets them settle for the warmup frames, then measures
+		if (SpawnedPawns.IsEmpty())
+		{
+			if (CompareVariable)
+			{
+				CompareVariable->Set(IsSecondPass() ? 1 : 0, ECVF_SetByConsole);
+			}
+			SpawnPawns(Settings.PawnCounts[BatchIndex / GetNumPasses()]);
+			FrameIndex = 0;
+			ReplayCursor = 0;
+			Samples.Reset();
+			LastFrameTime = Now;
+			return true;
+		}
+
+		FFrameSample Sample;
+		Sample.FrameMs = (Now - LastFrameTime) * 1000.0;
+		Sample.ActorTickMs = LastActorTickMs;
+		Sample.TagChanges = TagChangesThisFrame;
+		LastFrameTime = Now;
+		TagChangesThisFrame = 0;
+
+		DispatchInputs(Sample);
+
+		// The first sample covers the spawn frame
+		if (FrameIndex > Settings.WarmupFrames)
+		{
+			Samples.Add(Sample);
+		}
+
+		if (++FrameIndex > Settings.WarmupFrames + Settings.MeasuredFrames)
+		{
+			WriteBatch();
+			DestroyPawns();
+
+			// The next batch starts from a collected heap, its object counts and memory don't include these pawns
+			CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+
+			if (++BatchIndex >= NumRuns)
+			{
+				Finish();
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	void SpawnPawns(int32 Count)
+	{
+		for (int32 Index = 0; Index < Count; ++Index)
+		{
+			// Spread on a grid so movement based checks see pawns on the ground rather than stacked
+			const FTransform Transform(FVector(Index % 32 * Settings.Spacing, Index / 32 * Settings.Spacing, 200.0));
+			APawn* Pawn = World->SpawnActorDeferred<APawn>(Settings.PawnClass, Transform, nullptr, nullptr, ESpawnActorCollisionHandlingMethod::AlwaysSpawn);
+			if (!Pawn)
+			{
+				continue;
+			}
+
+			if (Settings.PreparePawn)
+			{
+				Settings.PreparePawn(*Pawn);
+			}
+			Pawn->FinishSpawning(Transform);
+
+			FSpawnedPawn& SpawnedPawn = SpawnedPawns.AddDefaulted_GetRef();
+			SpawnedPawn.Pawn = Pawn;
+			SpawnedPawn.InputHandler = Pawn->FindComponentByClass<UAbilityInputHandler>();
+
+			if (UAbilitySystemComponent* AbilitySystem = UAbilitySystemGlobals::GetAbilitySystemComponentFromActor(Pawn))
+			{
+				SpawnedPawn.AbilitySystem = AbilitySystem;
+				SpawnedPawn.TagChangedHandle = AbilitySystem->RegisterGenericGameplayTagEvent().AddLambda([this](const FGameplayTag, int32)
+				{
+					++TagChangesThisFrame;
+				});
+			}
+
+			NumStateTagHandlers += Pawn->FindComponentByClass<UAbilityStateTagHandler>() ? 1 : 0;
+		}
+	}
+
+	void DestroyPawns()
+	{
+		for (const FSpawnedPawn& SpawnedPawn : SpawnedPawns)
+		{
+			if (UAbilitySystemComponent* AbilitySystem = SpawnedPawn.AbilitySystem.Get())
+			{
+				AbilitySystem->RegisterGenericGameplayTagEvent().Remove(SpawnedPawn.TagChangedHandle);
+			}
+
+			if (APawn* Pawn = SpawnedPawn.Pawn.Get())
+			{
+				Pawn->Destroy();
+			}
+		}
+
+		SpawnedPawns.Reset();
+		NumStateTagHandlers = 0;
+	}
+
+	/**
+	 * Presses one bound tag per pawn, cycling through the config's bindings so abilities activate, fail and buffer.
+	 * With a replay, feeds every pawn the recorded inputs of the frame instead.
+	 */
+	void DispatchInputs(FFrameSample& Sample)
+	{
+		FGASScopedAllocationCounter AllocationCounter;
+		const double StartTime = FPlatformTime::Seconds();
+
+		if (!Settings.ReplayPath.IsEmpty())
+		{
+			ReplayInputs();
+		}
+		else
+		{
+			DispatchSyntheticInputs();
+		}
+
+		Sample.InputDispatchMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+		Sample.InputAllocations = AllocationCounter.GetNumAllocations();
+	}
+
+	void DispatchSyntheticInputs()
+	{
+		for (int32 PawnIndex = 0; PawnIndex < SpawnedPawns.Num(); ++PawnIndex)
+		{
+			UAbilityInputHandler* InputHandler = SpawnedPawns[PawnIndex].InputHandler.Get();
+			if (!InputHandler || !InputHandler->InputConfig)
+			{
+				continue;
+			}
+
+			const TArray<FGASInputBinding>& Bindings = InputHandler->InputConfig->GetCompiledBindings();
+			if (Bindings.IsEmpty())
+			{
+				continue;
+			}
+
+			const FGASInputBinding& Binding = Bindings[(FrameIndex + PawnIndex) % Bindings.Num()];
+			switch (Binding.EventType)
+			{
+			case GASInputEventType::GameplayAbility:
+				InputHandler->AbilityInput(Binding.InputTag, Binding.TriggerEvent);
+				break;
+			case GASInputEventType::GameplayEvent:
+				InputHandler->EventInput(Binding.InputTag, Binding.TriggerEvent);
+				break;
+			case GASInputEventType::GameplayDynamic:
+				InputHandler->DynamicInput(Binding.InputTag, Binding.TriggerEvent);
+				break;
+			default:
+				break;
+			}
+		}
+	}
+
+	/** Feeds the inputs recorded for this frame to every pawn whose input config matches the recording. */
+	void ReplayInputs()
+	{
+		const FGASInputRecording& Replay = Settings.Replay;
+		if (FrameIndex <= Settings.WarmupFrames || Replay.Inputs.IsEmpty())
+		{
+			return;
+		}
+
+		// Looped, the cursor goes back to the start with the frame
+		const uint32 ReplayFrame = static_cast<uint32>(FrameIndex - Settings.WarmupFrames - 1) % FMath::Max(Replay.NumFrames, 1u);
+		if (ReplayFrame == 0)
+		{
+			ReplayCursor = 0;
+		}
+
+		const int32 FirstInput = ReplayCursor;
+		while (ReplayCursor < Replay.Inputs.Num() && Replay.Inputs[ReplayCursor].Frame <= ReplayFrame)
+		{
+			++ReplayCursor;
+		}
+
+		for (const FSpawnedPawn& SpawnedPawn : SpawnedPawns)
+		{
+			UAbilityInputHandler* InputHandler = SpawnedPawn.InputHandler.Get();
+			if (!InputHandler || !Replay.IsCompatibleWith(InputHandler->InputConfig))
+			{
+				continue;
+			}
+
+			for (int32 InputIndex = FirstInput; InputIndex < ReplayCursor; ++InputIndex)
+			{
+				FGASInputRecording::Replay(*InputHandler, Replay.Inputs[InputIndex]);
+			}
+		}
+	}
+
+	void OnPreActorTick(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds)
+	{
+		if (InWorld == World.Get())
+		{
+			ActorTickStartTime = FPlatformTime::Seconds();
+		}
+	}
+
+	void OnPostActorTick(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds)
+	{
+		if (InWorld == World.Get())
+		{
+			LastActorTickMs = (FPlatformTime::Seconds() - ActorTickStartTime) * 1000.0;
+		}
+	}
+
+	static double Percentile(TArray<double>& Values, double Fraction)
+	{
+		if (Values.IsEmpty())
+		{
+			return 0.0;
+		}
+
+		Values.Sort();
+		const int32 Index = FMath::Clamp(FMath::CeilToInt32(Fraction * Values.Num()) - 1, 0, Values.Num() - 1);
+		return Values[Index];
+	}
+
+	static TSharedRef<FJsonObject> Summarize(TArray<double>& Values)
+	{
+		double Total = 0.0;
+		for (const double Value : Values)
+		{
+			Total += Value;
+		}
+
+		TSharedRef<FJsonObject> Summary = MakeShared<FJsonObject>();
+		Summary->SetNumberField(TEXT("avg"), Values.IsEmpty() ? 0.0 : Total / Values.Num());
+		Summary->SetNumberField(TEXT("p50"), Percentile(Values, 0.5));
+		Summary->SetNumberField(TEXT("p95"), Percentile(Values, 0.95));
+		Summary->SetNumberField(TEXT("p99"), Percentile(Values, 0.99));
+		Summary->SetNumberField(TEXT("max"), Values.IsEmpty() ? 0.0 : Values.Last());
+		return Summary;
+	}
+
+	void WriteBatch()
+	{
+		TArray<double> FrameMs, ActorTickMs, InputDispatchMs;
+		uint64 InputAllocations = 0;
+		int64 TagChanges = 0;
+		for (const FFrameSample& Sample : Samples)
+		{
+			FrameMs.Add(Sample.FrameMs);
+			ActorTickMs.Add(Sample.ActorTickMs);
+			InputDispatchMs.Add(Sample.InputDispatchMs);
+			InputAllocations += Sample.InputAllocations;
+			TagChanges += Sample.TagChanges;
+		}
+
+		const int32 NumFrames = FMath::Max(Samples.Num(), 1);
+
+		TSharedRef<FJsonObject> Batch = MakeShared<FJsonObject>();
+		Batch->SetNumberField(TEXT("pawns"), SpawnedPawns.Num());
+		Batch->SetNumberField(TEXT("stateTagHandlers"), NumStateTagHandlers);
+		Batch->SetNumberField(TEXT("frames"), Samples.Num());
+		Batch->SetObjectField(TEXT("frameMs"), Summarize(FrameMs));
+		Batch->SetObjectField(TEXT("actorTickMs"), Summarize(ActorTickMs));
+		Batch->SetObjectField(TEXT("inputDispatchMs"), Summarize(InputDispatchMs));
+		Batch->SetNumberField(TEXT("inputAllocations"), static_cast<double>(InputAllocations));
+		Batch->SetNumberField(TEXT("inputAllocationsPerFrame"), static_cast<double>(InputAllocations) / NumFrames);
+		Batch->SetNumberField(TEXT("tagChanges"), static_cast<double>(TagChanges));
+		Batch->SetNumberField(TEXT("tagChangesPerFrame"), static_cast<double>(TagChanges) / NumFrames);
+
+		// Tells runs with the per tick evaluation and the world scheduler apart
+		if (const FSpawnedPawn* FirstPawn = SpawnedPawns.GetData(); FirstPawn && FirstPawn->Pawn.IsValid())
+		{
+			if (const UAbilityStateTagHandler* StateTagHandler = FirstPawn->Pawn->FindComponentByClass<UAbilityStateTagHandler>())
+			{
+				Batch->SetStringField(TEXT("stateCheckMode"), StateTagHandler->bUseWorldScheduler ? TEXT("WorldScheduler") : TEXT("PerTick"));
+			}
+		}
+		Batch->SetBoolField(TEXT("lod"), LODEnableVariable && LODEnableVariable->GetBool());
+		Batch->SetBoolField(TEXT("sharedStateChecks"), ShareStatelessVariable && ShareStatelessVariable->GetBool());
+		Batch->SetBoolField(TEXT("compactTagReplication"), CompactReplicationVariable && CompactReplicationVariable->GetBool());
+		if (CompareVariable)
+		{
+			Batch->SetNumberField(TEXT("compareValue"), CompareVariable->GetInt());
+		}
+
+		// Object and memory footprint of the batch, with every pawn still alive
+		int32 NumStateCheckObjects = 0;
+		for (TObjectIterator<UAbilityStateCheck_Base> It; It; ++It)
+		{
+			++NumStateCheckObjects;
+		}
+		const double GCStartTime = FPlatformTime::Seconds();
+		CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS, true);
+		Batch->SetNumberField(TEXT("fullGCMs"), (FPlatformTime::Seconds() - GCStartTime) * 1000.0);
+		Batch->SetNumberField(TEXT("uobjects"), GUObjectArray.GetObjectArrayNumMinusAvailable());
+		Batch->SetNumberField(TEXT("stateCheckObjects"), NumStateCheckObjects);
+		Batch->SetNumberField(TEXT("usedPhysicalMB"), static_cast<double>(FPlatformMemory::GetStats().UsedPhysical) / (1024.0 * 1024.0));
+
+		Batches.Add(MakeShared<FJsonValueObject>(Batch));
+	}
+
+	void Finish()
+	{
+		if (bDone)
+		{
+			return;
+		}
+		bDone = true;
+
+		if (CompareVariable)
+		{
+			CompareVariable->Set(*InitialCompareValue, ECVF_SetByConsole);
+		}
+
+		TSharedRef<FJsonObject> Report = MakeShared<FJsonObject>();
+		Report->SetStringField(TEXT("pawnClass"), GetNameSafe(Settings.PawnClass));
+		Report->SetStringField(TEXT("buildConfiguration"), LexToString(FApp::GetBuildConfiguration()));
+		Report->SetNumberField(TEXT("warmupFrames"), Settings.WarmupFrames);
+		Report->SetNumberField(TEXT("spacing"), Settings.Spacing);
+
+		// Replication costs only show up on a server with connected clients
+		if (const UWorld* BenchmarkWorld = World.Get())
+		{
+			Report->SetBoolField(TEXT("server"), BenchmarkWorld->GetNetMode() == NM_DedicatedServer || BenchmarkWorld->GetNetMode() == NM_ListenServer);
+		}
+		if (CompareVariable)
+		{
+			Report->SetStringField(TEXT("compare"), Settings.CompareVariableName);
+		}
+		if (!Settings.ReplayPath.IsEmpty())
+		{
+			Report->SetStringField(TEXT("replay"), Settings.ReplayPath);
+			Report->SetNumberField(TEXT("replayFrames"), Settings.Replay.NumFrames);
+			Report->SetNumberField(TEXT("replayInputs"), Settings.Replay.Inputs.Num());
+		}
+		Report->SetArrayField(TEXT("batches"), Batches);
+
+		FString Json;
+		const TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Json);
+		FJsonSerializer::Serialize(Report, Writer);
+
+		if (FFileHelper::SaveStringToFile(Json, *Settings.OutputPath))
+		{
+			UE_LOG(LogTemp, Log, TEXT("GAS.Benchmark: wrote %s"), *Settings.OutputPath);
+		}
+		else
+		{
+			UE_LOG(LogTemp, Error, TEXT("GAS.Benchmark: could not write %s"), *Settings.OutputPath);
+		}
+		UE_LOG(LogTemp, Log, TEXT("%s"), *Json);
+
+		if (Settings.bQuitWhenDone)
+		{
+			FPlatformMisc::RequestExit(false);
+		}
+	}
+
+	int32 GetNumPasses() const { return CompareVariable ? 2 : 1; }
+
+	/** When comparing, the second run of each count has the compared variable set. */
+	bool IsSecondPass() const { return BatchIndex % GetNumPasses() == 1; }
+
+	TWeakObjectPtr<UWorld> World;
+	FSettings Settings;
+
+	IConsoleVariable* LODEnableVariable = nullptr;
+	IConsoleVariable* ShareStatelessVariable = nullptr;
+	IConsoleVariable* CompactReplicationVariable = nullptr;
+	IConsoleVariable* CompareVariable = nullptr;
+	FString InitialCompareValue;
+	int32 NumRuns = 0;
+
+	FTSTicker::FDelegateHandle TickerHandle;
+	FDelegateHandle PreActorTickHandle;
+	FDelegateHandle PostActorTickHandle;
+
+	TArray<FSpawnedPawn> SpawnedPawns;
+	int32 NumStateTagHandlers = 0;
+	int32 BatchIndex = 0;
+	int32 FrameIndex = 0;
+	int32 ReplayCursor = 0;
+	TArray<FFrameSample> Samples;
+	TArray<TSharedPtr<FJsonValue>> Batches;
+
+	double LastFrameTime = 0.0;
+	double ActorTickStartTime = 0.0;
+	double LastActorTickMs = 0.0;
+	int32 TagChangesThisFrame = 0;
+	bool bDone = false;
+};
+
+static TUniquePtr<FGASBenchmarkRunner> GASBenchmarkRunner;
+
+static FAutoConsoleCommandWithWorldAndArgs GASBenchmarkCommand(
+	TEXT("GAS.Benchmark"),
+	TEXT("Spawns batches of pawns with ability input and state tag handlers, drives synthetic input and writes the per frame cost as JSON.\n")
+	TEXT("Usage: GAS.Benchmark [Pawn=/Game/Path.Class_C] [Counts=1,100,1000] [Warmup=60] [Frames=300] [Out=File.json] [Spacing=200] [Compare=CVar|CompareLOD|CompareSharing|CompareCompactReplication] [Replay=File.gasinput] [Quit]\n")
+	TEXT("Pawn defaults to the game mode's default pawn class, Out to the profiling directory. Compare runs each count with the variable at 0 then 1.\n")
+	TEXT("Run CompareCompactReplication on a server with pawns using compact tag replication to compare its server cost against loose tags."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (GASBenchmarkRunner && !GASBenchmarkRunner->IsDone())
+		{
+			UE_LOG(LogTemp, Warning, TEXT("GAS.Benchmark: a benchmark is already running."));
+			return;
+		}
+		GASBenchmarkRunner.Reset();
+
+		if (!World)
+		{
+			return;
+		}
+
+		const FString Params = FString::Join(Args, TEXT(" "));
+		FGASBenchmarkRunner::FSettings Settings;
+
+		FString PawnClassPath;
+		if (FParse::Value(*Params, TEXT("Pawn="), PawnClassPath))
+		{
+			Settings.PawnClass = LoadClass<APawn>(nullptr, *PawnClassPath);
+		}
+		else if (const AGameModeBase* GameMode = World->GetAuthGameMode())
+		{
+			Settings.PawnClass = GameMode->DefaultPawnClass;
+		}
+
+		if (!Settings.PawnClass)
+		{
+			UE_LOG(LogTemp, Error, TEXT("GAS.Benchmark: no pawn class, pass Pawn= or run it on the server with a game mode."));
+			return;
+		}
+
+		FString Counts = TEXT("1,100,1000");
+		FParse::Value(*Params, TEXT("Counts="), Counts);
+		TArray<FString> CountStrings;
+		Counts.ParseIntoArray(CountStrings, TEXT(","));
+		for (const FString& CountString : CountStrings)
+		{
+			Settings.PawnCounts.Add(FMath::Max(FCString::Atoi(*CountString), 1));
+		}
+
+		// A replay is measured over its whole length unless told otherwise
+		if (FParse::Value(*Params, TEXT("Replay="), Settings.ReplayPath))
+		{
+			if (!Settings.Replay.LoadFromFile(Settings.ReplayPath))
+			{
+				UE_LOG(LogTemp, Error, TEXT("GAS.Benchmark: could not load the input recording %s."), *Settings.ReplayPath);
+				return;
+			}
+			Settings.MeasuredFrames = static_cast<int32>(Settings.Replay.NumFrames);
+		}
+
+		FParse::Value(*Params, TEXT("Warmup="), Settings.WarmupFrames);
+		FParse::Value(*Params, TEXT("Frames="), Settings.MeasuredFrames);
+		Settings.WarmupFrames = FMath::Max(Settings.WarmupFrames, 0);
+		Settings.MeasuredFrames = FMath::Max(Settings.MeasuredFrames, 1);
+
+		if (!FParse::Value(*Params, TEXT("Out="), Settings.OutputPath))
+		{
+			Settings.OutputPath = FPaths::ProfilingDir() / FString::Printf(TEXT("GASBenchmark-%s.json"), *FDateTime::Now().ToString());
+		}
+
+		FParse::Value(*Params, TEXT("Spacing="), Settings.Spacing);
+		Settings.Spacing = FMath::Max(Settings.Spacing, 1.0);
+
+		Settings.bQuitWhenDone = Args.ContainsByPredicate([](const FString& Arg) { return Arg.Equals(TEXT("Quit"), ESearchCase::IgnoreCase); });
+		const auto HasFlag = [&Args](const TCHAR* Flag) { return Args.ContainsByPredicate([Flag](const FString& Arg) { return Arg.Equals(Flag, ESearchCase::IgnoreCase); }); };
+		if (!FParse::Value(*Params, TEXT("Compare="), Settings.CompareVariableName))
+		{
+			if (HasFlag(TEXT("CompareLOD")))
+			{
+				Settings.CompareVariableName = TEXT("AbilityStateCheck.LOD.Enable");
+			}
+			else if (HasFlag(TEXT("CompareSharing")))
+			{
+				Settings.CompareVariableName = TEXT("AbilityStateCheck.ShareStatelessChecks");
+			}
+			else if (HasFlag(TEXT("CompareCompactReplication")))
+			{
+				Settings.CompareVariableName = TEXT("AbilityStateCheck.CompactTagReplication");
+			}
+		}
+		if (!Settings.CompareVariableName.IsEmpty() && !IConsoleManager::Get().FindConsoleVariable(*Settings.CompareVariableName))
+		{
+			UE_LOG(LogTemp, Error, TEXT("GAS.Benchmark: no console variable named %s to compare."), *Settings.CompareVariableName);
+			return;
+		}
+
+		if (Settings.PawnCounts.IsEmpty())
+		{
+			UE_LOG(LogTemp, Error, TEXT("GAS.Benchmark: no pawn counts."));
+			return;
+		}
+
+		UE_LOG(LogTemp, Log, TEXT("GAS.Benchmark: %s, %s pawns, %d warmup and %d measured frames per batch."),
+			*Settings.PawnClass->GetName(), *Counts, Settings.WarmupFrames, Settings.MeasuredFrames);
+		GASBenchmarkRunner = MakeUnique<FGASBenchmarkRunner>(World, MoveTemp(Settings));
+	}));
+
+/** Shape of the random combos and presses of the combo matcher benchmark. */
+struct FGASComboBenchmarkSettings
+{
+	int32 NumCombos = 500;
+	int32 NumActions = 32;
+	int32 MaxSteps = 4;
+	float ChordRatio = 0.25f;
+	int32 NumPresses = 1000000;
+	int32 Seed = 0;
+};
+
+struct FGASComboBenchmarkResult
+{
+	double CompileMs = 0.0;
+	int32 NumStates = 0;
+	double AllocatedKB = 0.0;
+	int32 NumPresses = 0;
+	double NanosecondsPerPress = 0.0;
+	int32 NumCompleted = 0;
+
+	/** Heap allocations made while matching the presses, not compiling. */
+	uint64 MatchAllocations = 0;
+};
+
+/**
+ * Compiles a transient input config with many random combos and feeds one pawn's worth of combo state random presses
+ * and releases, timing the compile and every press through the matcher. Returns false if no gameplay tag is registered
+ * for the combos to send.
+ */
+static bool RunComboBenchmark(FGASComboBenchmarkSettings Settings, FGASComboBenchmarkResult& OutResult)
+{
+	Settings.NumActions = FMath::Clamp(Settings.NumActions, 2, FGASInputComboMatcher::MaxSymbols);
+	Settings.MaxSteps = FMath::Clamp(Settings.MaxSteps, 2, FGASInputComboState::MaxSteps);
+	const int32 NumActions = Settings.NumActions;
+
+	// Only dispatch needs a meaningful tag, any registered one will do
+	FGameplayTagContainer AllTags;
+	UGameplayTagsManager::Get().RequestAllGameplayTags(AllTags, true);
+	if (AllTags.IsEmpty())
+	{
+		return false;
+	}
+
+	UGASInputConfig* InputConfig = NewObject<UGASInputConfig>(GetTransientPackage());
+	TArray<UInputAction*> InputActions;
+	for (int32 Index = 0; Index < NumActions; ++Index)
+	{
+		InputActions.Add(NewObject<UInputAction>(InputConfig));
+	}
+
+	FRandomStream Random(Settings.Seed);
+	for (int32 Index = 0; Index < Settings.NumCombos; ++Index)
+	{
+		FGASInputCombo& Combo = InputConfig->Combos.AddDefaulted_GetRef();
+		Combo.Type = Random.FRand() < Settings.ChordRatio ? EGASInputComboType::Chord : EGASInputComboType::Sequence;
+		Combo.InputTag = AllTags.GetByIndex(Index % AllTags.Num());
+		// Chords need distinct actions, there can't be more steps than actions
+		const int32 NumSteps = Random.RandRange(2, Combo.Type == EGASInputComboType::Chord ? FMath::Min(3, NumActions) : Settings.MaxSteps);
+		for (int32 Step = 0; Step < NumSteps; ++Step)
+		{
+			// Sequences may repeat an action
+			UInputAction* InputAction = InputActions[Random.RandHelper(NumActions)];
+			while (Combo.Type == EGASInputComboType::Chord && Combo.Actions.Contains(InputAction))
+			{
+				InputAction = InputActions[Random.RandHelper(NumActions)];
+			}
+			Combo.Actions.Add(InputAction);
+		}
+	}
+
+	const double CompileStartTime = FPlatformTime::Seconds();
+	const FGASInputComboMatcher& ComboMatcher = InputConfig->GetComboMatcher();
+	OutResult.CompileMs = (FPlatformTime::Seconds() - CompileStartTime) * 1000.0;
+	OutResult.NumStates = ComboMatcher.GetNumStates();
+	OutResult.AllocatedKB = ComboMatcher.GetAllocatedSize() / 1024.0;
+
+	// Presses 50 to 400 ms apart, a third of them held over the next press so chords can complete. Generated up front
+	// so only the matcher is timed
+	struct FPress
+	{
+		double Time = 0.0;
+		int32 Symbol = INDEX_NONE;
+		bool bHold = false;
+	};
+	TArray<FPress> Presses;
+	Presses.Reserve(Settings.NumPresses);
+	double Time = 0.0;
+	for (int32 Press = 0; Press < Settings.NumPresses; ++Press)
+	{
+		Time += Random.FRandRange(0.05f, 0.4f);
+		const int32 Symbol = ComboMatcher.FindSymbol(InputActions[Random.RandHelper(NumActions)]);
+		if (Symbol != INDEX_NONE)
+		{
+			Presses.Add({ Time, Symbol, Random.RandHelper(3) == 0 });
+		}
+	}
+
+	FGASInputComboState ComboState;
+	int32 NumCompleted = 0;
+	int32 HeldSymbol = INDEX_NONE;
+	FGASScopedAllocationCounter AllocationCounter;
+	const double MatchStartTime = FPlatformTime::Seconds();
+	for (const FPress& Press : Presses)
+	{
+		if (HeldSymbol != INDEX_NONE && HeldSymbol != Press.Symbol)
+		{
+			ComboMatcher.OnReleased(ComboState, HeldSymbol);
+		}
+		NumCompleted += ComboMatcher.OnPressed(ComboState, Press.Symbol, Press.Time) ? 1 : 0;
+		if (!Press.bHold)
+		{
+			ComboMatcher.OnReleased(ComboState, Press.Symbol);
+		}
+		HeldSymbol = Press.bHold ? Press.Symbol : INDEX_NONE;
+	}
+	const double MatchSeconds = FPlatformTime::Seconds() - MatchStartTime;
+	OutResult.MatchAllocations = AllocationCounter.GetNumAllocations();
+
+	OutResult.NumPresses = Presses.Num();
+	OutResult.NanosecondsPerPress = MatchSeconds * 1.0e9 / FMath::Max(Presses.Num(), 1);
+	OutResult.NumCompleted = NumCompleted;
+
+	InputConfig->MarkAsGarbage();
+	return true;
+}
+
+static FAutoConsoleCommand GASBenchmarkCombosCommand(
+	TEXT("GAS.Benchmark.Combos"),
+	TEXT("Times the combo matcher of an input config with many random chords and sequences.\n")
+	TEXT("Usage: GAS.Benchmark.Combos [Combos=500] [Actions=32] [MaxSteps=4] [Chords=0.25] [Presses=1000000] [Seed=0]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const FString Params = FString::Join(Args, TEXT(" "));
+		FGASComboBenchmarkSettings Settings;
+		FParse::Value(*Params, TEXT("Combos="), Settings.NumCombos);
+		FParse::Value(*Params, TEXT("Actions="), Settings.NumActions);
+		FParse::Value(*Params, TEXT("MaxSteps="), Settings.MaxSteps);
+		FParse::Value(*Params, TEXT("Chords="), Settings.ChordRatio);
+		FParse::Value(*Params, TEXT("Presses="), Settings.NumPresses);
+		FParse::Value(*Params, TEXT("Seed="), Settings.Seed);
+
+		FGASComboBenchmarkResult Result;
+		if (!RunComboBenchmark(Settings, Result))
+		{
+			UE_LOG(LogTemp, Error, TEXT("GAS.Benchmark.Combos: no gameplay tag registered to send."));
+			return;
+		}
+
+		UE_LOG(LogTemp, Log, TEXT("GAS.Benchmark.Combos: %d combos compiled in %.3f ms to %d states, %.1f KB."),
+			Settings.NumCombos, Result.CompileMs, Result.NumStates, Result.AllocatedKB);
+		UE_LOG(LogTemp, Log, TEXT("GAS.Benchmark.Combos: %d presses, %.1f ns each, %d combos completed, %llu allocations."),
+			Result.NumPresses, Result.NanosecondsPerPress, Result.NumCompleted, Result.MatchAllocations);
+	}));
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/**
+ * Ticks the test world until the benchmark is done, then hands its batches to the checks of the test. The pawns are test
+ * pawns given the test input config and state checks, then whatever the settings' PreparePawn does on top.
+ */
+class FGASBenchmarkTestCommand : public IAutomationLatentCommand
+{
+public:
+	/** Checks the batches of the finished benchmark, as written to the report. */
+	using FCheckBatches = TFunction<void(FAutomationTestBase&, const TArray<TSharedPtr<FJsonValue>>&)>;
+
+	FGASBenchmarkTestCommand(FAutomationTestBase& InTest, FGASBenchmarkRunner::FSettings&& Settings, FCheckBatches&& InCheckBatches)
+		: Test(InTest)
+		, CheckBatches(MoveTemp(InCheckBatches))
+		, TestWorld(MakeUnique<FGASTestWorld>())
+		, InputConfig(GASTest::CreateInputConfig())
+		, StateChecks(GASTest::CreateStateChecks())
+	{
+		TFunction<void(APawn&)> PrepareTestPawn = MoveTemp(Settings.PreparePawn);
+		Settings.PawnClass = AGASTestPawn::StaticClass();
+		Settings.PreparePawn = [InputConfig = InputConfig.Get(), StateChecks = StateChecks.Get(), PrepareTestPawn = MoveTemp(PrepareTestPawn)](APawn& Pawn)
+		{
+			GASTest::ConfigurePawn(Pawn, InputConfig, StateChecks);
+			if (PrepareTestPawn)
+			{
+				PrepareTestPawn(Pawn);
+			}
+		};
+		Runner = MakeUnique<FGASBenchmarkRunner>(TestWorld->GetWorld(), MoveTemp(Settings));
+	}
+
+	virtual ~FGASBenchmarkTestCommand() override
+	{
+		// The pawns go before their world
+		Runner.Reset();
+		TestWorld.Reset();
+	}
+
+	virtual bool Update() override
+	{
+		// The runner ticks from the core ticker, once per engine frame like this command
+		if (!Runner->IsDone())
+		{
+			TestWorld->Tick(1.f / 60.f);
+			return false;
+		}
+
+		const TArray<TSharedPtr<FJsonValue>>& Batches = Runner->GetBatches();
+		if (Test.TestFalse(TEXT("Benchmark ran"), Batches.IsEmpty()))
+		{
+			CheckBatches(Test, Batches);
+		}
+		return true;
+	}
+
+private:
+	FAutomationTestBase& Test;
+	FCheckBatches CheckBatches;
+	TUniquePtr<FGASTestWorld> TestWorld;
+	TStrongObjectPtr<UGASInputConfig> InputConfig;
+	TStrongObjectPtr<UAbilityStateCheckObjects> StateChecks;
+	TUniquePtr<FGASBenchmarkRunner> Runner;
+};
+
+namespace GASBenchmarkTest
+{
+	/** Average of a frame cost of a batch, in microseconds per pawn. */
+	double GetMicrosecondsPerPawn(const FJsonObject& Batch, const TCHAR* FieldName)
+	{
+		const int32 NumPawns = FMath::Max(static_cast<int32>(Batch.GetNumberField(TEXT("pawns"))), 1);
+		return Batch.GetObjectField(FieldName)->GetNumberField(TEXT("avg")) * 1000.0 / NumPawns;
+	}
+
+	/**
+	 * Calls Compare with the two batches of each pawn count of a comparison, run with the compared variable at 0 then 1.
+	 * Logs how they differ first, so the numbers can be read from the automation report.
+	 */
+	void ForEachComparison(FAutomationTestBase& Test, const TArray<TSharedPtr<FJsonValue>>& Batches,
+		TFunctionRef<void(int32 NumPawns, const FJsonObject& Off, const FJsonObject& On)> Compare)
+	{
+		for (int32 BatchIndex = 0; BatchIndex + 1 < Batches.Num(); BatchIndex += 2)
+		{
+			const FJsonObject& Off = *Batches[BatchIndex]->AsObject();
+			const FJsonObject& On = *Batches[BatchIndex + 1]->AsObject();
+			const int32 NumPawns = static_cast<int32>(On.GetNumberField(TEXT("pawns")));
+
+			Test.AddInfo(FString::Printf(TEXT("%d pawns, off / on: actor tick %.2f / %.2f us per pawn, %.0f / %.0f tag changes, %.0f / %.0f state check objects, ")
+				TEXT("%.0f / %.0f UObjects, full GC %.2f / %.2f ms, %.1f / %.1f MB used."),
+				NumPawns,
+				GetMicrosecondsPerPawn(Off, TEXT("actorTickMs")), GetMicrosecondsPerPawn(On, TEXT("actorTickMs")),
+				Off.GetNumberField(TEXT("tagChanges")), On.GetNumberField(TEXT("tagChanges")),
+				Off.GetNumberField(TEXT("stateCheckObjects")), On.GetNumberField(TEXT("stateCheckObjects")),
+				Off.GetNumberField(TEXT("uobjects")), On.GetNumberField(TEXT("uobjects")),
+				Off.GetNumberField(TEXT("fullGCMs")), On.GetNumberField(TEXT("fullGCMs")),
+				Off.GetNumberField(TEXT("usedPhysicalMB")), On.GetNumberField(TEXT("usedPhysicalMB"))));
+
+			Compare(NumPawns, Off, On);
+		}
+	}
+}
+
+/**
+ * Runs the benchmark on test pawns with 1, 100 and 1000 pawns and fails if input dispatch allocates or a batch goes over
+ * budget. The report is written to the profiling directory for the CI to keep. The budgets can be overridden for slower
+ * machines with -GASBenchmarkInputUs= and -GASBenchmarkActorTickUs=.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGASBenchmarkHandlersTest, "GAS_Test.Benchmark.Handlers",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+bool FGASBenchmarkHandlersTest::RunTest(const FString& Parameters)
+{
+	FGASBenchmarkRunner::FSettings Settings;
+	Settings.PawnCounts = { 1, 100, 1000 };
+	Settings.WarmupFrames = 30;
+	Settings.MeasuredFrames = 120;
+	Settings.OutputPath = FPaths::ProfilingDir() / TEXT("GASBenchmark-Automation.json");
+
+	// Average input dispatch time and actor tick time, mostly the state tag handler, per pawn and frame
+	double InputDispatchBudgetUs = 25.0;
+	double ActorTickBudgetUs = 100.0;
+	FParse::Value(FCommandLine::Get(), TEXT("GASBenchmarkInputUs="), InputDispatchBudgetUs);
+	FParse::Value(FCommandLine::Get(), TEXT("GASBenchmarkActorTickUs="), ActorTickBudgetUs);
+
+	FGASBenchmarkTestCommand::FCheckBatches CheckBudgets = [InputDispatchBudgetUs, ActorTickBudgetUs](FAutomationTestBase& Test, const TArray<TSharedPtr<FJsonValue>>& Batches)
+	{
+		for (const TSharedPtr<FJsonValue>& BatchValue : Batches)
+		{
+			const FJsonObject& Batch = *BatchValue->AsObject();
+			const int32 NumPawns = static_cast<int32>(Batch.GetNumberField(TEXT("pawns")));
+			const double InputDispatchUs = GASBenchmarkTest::GetMicrosecondsPerPawn(Batch, TEXT("inputDispatchMs"));
+			const double ActorTickUs = GASBenchmarkTest::GetMicrosecondsPerPawn(Batch, TEXT("actorTickMs"));
+
+			Test.TestEqual(FString::Printf(TEXT("Input allocations with %d pawns"), NumPawns), Batch.GetNumberField(TEXT("inputAllocations")), 0.0);
+			Test.TestTrue(FString::Printf(TEXT("Input dispatch of %.2f us per pawn with %d pawns is within %.2f us"), InputDispatchUs, NumPawns, InputDispatchBudgetUs),
+				InputDispatchUs <= InputDispatchBudgetUs);
+			Test.TestTrue(FString::Printf(TEXT("Actor tick of %.2f us per pawn with %d pawns is within %.2f us"), ActorTickUs, NumPawns, ActorTickBudgetUs),
+				ActorTickUs <= ActorTickBudgetUs);
+		}
+	};
+
+	ADD_LATENT_AUTOMATION_COMMAND(FGASBenchmarkTestCommand(*this, MoveTemp(Settings), MoveTemp(CheckBudgets)));
+	return true;
+}
+
+/**
+ * Compares test pawns replicating their state tags as compact bits against replicated loose tags. The test world is
+ * standalone, so this only covers the authority's side of each tag change; bandwidth and the cost to the net driver need
+ * GAS.Benchmark CompareCompactReplication on a server with connected clients.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGASBenchmarkCompactReplicationTest, "GAS_Test.Benchmark.CompactReplication",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+bool FGASBenchmarkCompactReplicationTest::RunTest(const FString& Parameters)
+{
+	FGASBenchmarkRunner::FSettings Settings;
+	Settings.PawnCounts = { 100, 1000 };
+	Settings.WarmupFrames = 30;
+	Settings.MeasuredFrames = 120;
+	Settings.CompareVariableName = TEXT("AbilityStateCheck.CompactTagReplication");
+	Settings.OutputPath = FPaths::ProfilingDir() / TEXT("GASBenchmark-CompactReplication.json");
+	Settings.PreparePawn = [](APawn& Pawn)
+	{
+		if (UAbilityStateTagHandler* StateTagHandler = Pawn.FindComponentByClass<UAbilityStateTagHandler>())
+		{
+			// Decided when the handler registers, which a deferred spawn has already done
+			StateTagHandler->bCompactTagReplication = true;
+			StateTagHandler->ReregisterComponent();
+		}
+	};
+
+	FGASBenchmarkTestCommand::FCheckBatches CheckBatches = [](FAutomationTestBase& Test, const TArray<TSharedPtr<FJsonValue>>& Batches)
+	{
+		GASBenchmarkTest::ForEachComparison(Test, Batches, [&Test](int32 NumPawns, const FJsonObject& LooseTags, const FJsonObject& CompactTags)
+		{
+			// Only how the tags reach the clients differs, the authority applies the same ones
+			Test.TestTrue(FString::Printf(TEXT("State tags changed with replicated loose tags and %d pawns"), NumPawns), LooseTags.GetNumberField(TEXT("tagChanges")) > 0.0);
+			Test.TestTrue(FString::Printf(TEXT("State tags changed with compact tag replication and %d pawns"), NumPawns), CompactTags.GetNumberField(TEXT("tagChanges")) > 0.0);
+		});
+	};
+
+	ADD_LATENT_AUTOMATION_COMMAND(FGASBenchmarkTestCommand(*this, MoveTemp(Settings), MoveTemp(CheckBatches)));
+	return true;
+}
+
+/**
+ * Compares 500 test pawns using UAbilityStateCheckSignificance with significance based LOD off and on. The test world has no
+ * player, so every pawn scores as far from any viewer and LOD suspends its checks, as for AI pawns past the significance
+ * distance. The first significance updates are staggered over half a second, covered by the warmup.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGASBenchmarkLODTest, "GAS_Test.Benchmark.LOD",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+bool FGASBenchmarkLODTest::RunTest(const FString& Parameters)
+{
+	FGASBenchmarkRunner::FSettings Settings;
+	Settings.PawnCounts = { 500 };
+	Settings.WarmupFrames = 60;
+	Settings.MeasuredFrames = 120;
+	Settings.Spacing = 1000.0;
+	Settings.CompareVariableName = TEXT("AbilityStateCheck.LOD.Enable");
+	Settings.OutputPath = FPaths::ProfilingDir() / TEXT("GASBenchmark-LOD.json");
+	Settings.PreparePawn = [](APawn& Pawn)
+	{
+		if (UAbilityStateTagHandler* StateTagHandler = Pawn.FindComponentByClass<UAbilityStateTagHandler>())
+		{
+			StateTagHandler->Significance = NewObject<UAbilityStateCheckSignificance>(StateTagHandler);
+		}
+	};
+
+	FGASBenchmarkTestCommand::FCheckBatches CheckBatches = [](FAutomationTestBase& Test, const TArray<TSharedPtr<FJsonValue>>& Batches)
+	{
+		GASBenchmarkTest::ForEachComparison(Test, Batches, [&Test](int32 NumPawns, const FJsonObject& FullRate, const FJsonObject& WithLOD)
+		{
+			// The alternating check keeps changing tags at full rate, and stops once suspended
+			Test.TestTrue(FString::Printf(TEXT("State tags changed at full rate with %d pawns"), NumPawns), FullRate.GetNumberField(TEXT("tagChanges")) > 0.0);
+			Test.TestTrue(FString::Printf(TEXT("LOD reduced the tag changes of %d pawns no viewer sees"), NumPawns),
+				WithLOD.GetNumberField(TEXT("tagChanges")) < FullRate.GetNumberField(TEXT("tagChanges")));
+		});
+	};
+
+	ADD_LATENT_AUTOMATION_COMMAND(FGASBenchmarkTestCommand(*this, MoveTemp(Settings), MoveTemp(CheckBatches)));
+	return true;
+}
+
+/**
+ * Compares 100 and 1000 test pawns with the stateless test check instanced per pawn, then shared by all of them, for the
+ * UObject count, the time of a full GC and the memory used.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGASBenchmarkSharingTest, "GAS_Test.Benchmark.Sharing",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+bool FGASBenchmarkSharingTest::RunTest(const FString& Parameters)
+{
+	FGASBenchmarkRunner::FSettings Settings;
+	Settings.PawnCounts = { 100, 1000 };
+	Settings.WarmupFrames = 30;
+	Settings.MeasuredFrames = 60;
+	Settings.CompareVariableName = TEXT("AbilityStateCheck.ShareStatelessChecks");
+	Settings.OutputPath = FPaths::ProfilingDir() / TEXT("GASBenchmark-Sharing.json");
+
+	FGASBenchmarkTestCommand::FCheckBatches CheckBatches = [](FAutomationTestBase& Test, const TArray<TSharedPtr<FJsonValue>>& Batches)
+	{
+		GASBenchmarkTest::ForEachComparison(Test, Batches, [&Test](int32 NumPawns, const FJsonObject& Instanced, const FJsonObject& Shared)
+		{
+			// One state check object less per pawn, the shared instance being the asset's own
+			const double SavedObjects = Instanced.GetNumberField(TEXT("stateCheckObjects")) - Shared.GetNumberField(TEXT("stateCheckObjects"));
+			Test.TestTrue(FString::Printf(TEXT("Sharing saved %.0f state check objects with %d pawns"), SavedObjects, NumPawns), SavedObjects >= NumPawns);
+		});
+	};
+
+	ADD_LATENT_AUTOMATION_COMMAND(FGASBenchmarkTestCommand(*this, MoveTemp(Settings), MoveTemp(CheckBatches)));
+	return true;
+}
+
+/**
+ * Times the combo matcher of 500 random combos over 32 actions and fails if matching allocates, never completes a combo or
+ * goes over budget per press. The budget can be overridden for slower machines with -GASBenchmarkComboNs=.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGASBenchmarkCombosTest, "GAS_Test.Benchmark.Combos",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+bool FGASBenchmarkCombosTest::RunTest(const FString& Parameters)
+{
+	FGASComboBenchmarkSettings Settings;
+	Settings.NumPresses = 200000;
+
+	double PressBudgetNs = 200.0;
+	FParse::Value(FCommandLine::Get(), TEXT("GASBenchmarkComboNs="), PressBudgetNs);
+
+	FGASComboBenchmarkResult Result;
+	if (!TestTrue(TEXT("Gameplay tags registered for the combos"), RunComboBenchmark(Settings, Result)))
+	{
+		return false;
+	}
+
+	AddInfo(FString::Printf(TEXT("%d combos compiled in %.3f ms to %d states, %.1f KB. %d presses, %.1f ns each, %d combos completed."),
+		Settings.NumCombos, Result.CompileMs, Result.NumStates, Result.AllocatedKB, Result.NumPresses, Result.NanosecondsPerPress, Result.NumCompleted));
+
+	TestTrue(FString::Printf(TEXT("Combos completed over %d presses"), Result.NumPresses), Result.NumCompleted > 0);
+	TestEqual(TEXT("Allocations while matching"), Result.MatchAllocations, uint64(0));
+	TestTrue(FString::Printf(TEXT("Matching of %.1f ns per press is within %.1f ns"), Result.NanosecondsPerPress, PressBudgetNs),
+		Result.NanosecondsPerPress <= PressBudgetNs);
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
+
+#endif // !UE_BUILD_SHIPPING
@@ -0,0 +1,278 @@
+﻿#include "GASInputCombo.h"
+#include "GASInputConfig.h"
+#include "InputAction.h"
+
+void FGASInputComboMatcher::Compile(const TArray<FGASInputCombo>& Combos, const UObject* Owner)
+{
+	Reset();
+
+	struct FPendingSequence
+	{
+		TArray<int32, TInlineAllocator<FGASInputComboState::MaxSteps>> Symbols;
+		int32 ComboIndex = INDEX_NONE;
+	};
+	struct FPendingChord
+	{
+		int32 Symbol = INDEX_NONE;
+		FChord Chord;
+	};
+	TArray<FPendingSequence> PendingSequences;
+	TArray<FPendingChord> PendingChords;
+
+	// Validate every combo and give each of their actions a symbol, the tables are sized from the symbol count
+	for (int32 Index = 0; Index < Combos.Num(); ++Index)
+	{
+		const FGASInputCombo& Combo = Combos[Index];
+		const bool bSequence = Combo.Type == EGASInputComboType::Sequence;
+		if (!Combo.InputTag.IsValid() || Combo.EventType == GASInputEventType::NotApplicable || Combo.Actions.Num() < 2
+			|| Combo.Actions.Contains(nullptr) || (bSequence && Combo.Actions.Num() > FGASInputComboState::MaxSteps))
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Skipping combo %d of %s: it needs a tag, an event type and 2 to %d actions."),
+				Index, *GetNameSafe(Owner), FGASInputComboState::MaxSteps);
+			continue;
+		}
+
+		TArray<int32, TInlineAllocator<FGASInputComboState::MaxSteps>> Symbols;
+		for (const UInputAction* InputAction : Combo.Actions)
+		{
+			int32 Symbol = FindSymbol(InputAction);
+			if (Symbol == INDEX_NONE && Actions.Num() < MaxSymbols)
+			{
+				Symbol = Actions.Add(InputAction);
+				SymbolByAction.Add(InputAction, Symbol);
+			}
+			Symbols.Add(Symbol);
+		}
+		if (Symbols.Contains(INDEX_NONE))
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Skipping combo %d of %s: combos may use at most %d different actions."), Index, *GetNameSafe(Owner), MaxSymbols);
+			continue;
+		}
+
+		uint64 ChordSymbols = 0;
+		for (const int32 Symbol : Symbols)
+		{
+			ChordSymbols |= uint64(1) << Symbol;
+		}
+		if (!bSequence && FMath::CountBits(ChordSymbols) != Symbols.Num())
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Skipping combo %d of %s: a chord can't use an action twice."), Index, *GetNameSafe(Owner));
+			continue;
+		}
+
+		FGASCompiledInputCombo& CompiledCombo = CompiledCombos.AddDefaulted_GetRef();
+		CompiledCombo.InputTag = Combo.InputTag;
+		CompiledCombo.EventType = Combo.EventType;
+		CompiledCombo.NumSteps = static_cast<uint8>(Symbols.Num());
+		CompiledCombo.MaxStepInterval = Combo.MaxStepInterval;
+
+		if (bSequence)
+		{
+			PendingSequences.Add({ Symbols, CompiledCombos.Num() - 1 });
+			MaxStepInterval = FMath::Max(MaxStepInterval, Combo.MaxStepInterval);
+			continue;
+		}
+
+		FPendingChord& PendingChord = PendingChords.AddDefaulted_GetRef();
+		PendingChord.Symbol = Symbols.Last();
+		PendingChord.Chord.RequiredHeld = ChordSymbols & ~(uint64(1) << Symbols.Last());
+		PendingChord.Chord.ComboIndex = CompiledCombos.Num() - 1;
+	}
+
+	const int32 NumSymbols = Actions.Num();
+	if (NumSymbols == 0)
+	{
+		return;
+	}
+
+	// Trie of the sequences, missing transitions are INDEX_NONE until the automaton is completed
+	auto AddState = [this, NumSymbols]()
+	{
+		Transitions.Reserve(Transitions.Num() + NumSymbols);
+		for (int32 Symbol = 0; Symbol < NumSymbols; ++Symbol)
+		{
+			Transitions.Add(INDEX_NONE);
+		}
+		return StateOutputs.Add(INDEX_NONE);
+	};
+	AddState();
+
+	for (const FPendingSequence& Sequence : PendingSequences)
+	{
+		int32 State = 0;
+		for (const int32 Symbol : Sequence.Symbols)
+		{
+			if (Transitions[State * NumSymbols + Symbol] == INDEX_NONE)
+			{
+				const int32 NewState = AddState();
+				Transitions[State * NumSymbols + Symbol] = NewState;
+			}
+			State = Transitions[State * NumSymbols + Symbol];
+		}
+
+		if (StateOutputs[State] != INDEX_NONE)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Combo sending %s in %s repeats the sequence of another combo and will never fire."),
+				*CompiledCombos[Sequence.ComboIndex].InputTag.ToString(), *GetNameSafe(Owner));
+			continue;
+		}
+		StateOutputs[State] = Sequence.ComboIndex;
+	}
+
+	// Breadth first, a state's fallback is shallower so its transitions are already complete when the state is reached
+	TArray<int32> Fallbacks;
+	Fallbacks.Init(0, StateOutputs.Num());
+	OutputLinks.Init(INDEX_NONE, StateOutputs.Num());
+
+	TArray<int32> Queue;
+	Queue.Reserve(StateOutputs.Num());
+	for (int32 Symbol = 0; Symbol < NumSymbols; ++Symbol)
+	{
+		int32& Next = Transitions[Symbol];
+		if (Next == INDEX_NONE)
+		{
+			Next = 0;
+		}
+		else
+		{
+			Queue.Add(Next);
+		}
+	}
+
+	for (int32 QueueIndex = 0; QueueIndex < Queue.Num(); ++QueueIndex)
+	{
+		const int32 State = Queue[QueueIndex];
+		const int32 Fallback = Fallbacks[State];
+		for (int32 Symbol = 0; Symbol < NumSymbols; ++Symbol)
+		{
+			const int32 Child = Transitions[State * NumSymbols + Symbol];
+			const int32 FallbackNext = Transitions[Fallback * NumSymbols + Symbol];
+			if (Child == INDEX_NONE)
+			{
+				Transitions[State * NumSymbols + Symbol] = FallbackNext;
+				continue;
+			}
+
+			Fallbacks[Child] = FallbackNext;
+			OutputLinks[Child] = StateOutputs[FallbackNext] != INDEX_NONE ? FallbackNext : OutputLinks[FallbackNext];
+			Queue.Add(Child);
+		}
+	}
+
+	// Chords of one action are contiguous, with the most specific one first so it wins over the chords it contains
+	PendingChords.Sort([](const FPendingChord& A, const FPendingChord& B)
+	{
+		if (A.Symbol != B.Symbol)
+		{
+			return A.Symbol < B.Symbol;
+		}
+		return FMath::CountBits(A.Chord.RequiredHeld) > FMath::CountBits(B.Chord.RequiredHeld);
+	});
+
+	ChordRangeBySymbol.Init(TPair<int32, int32>(0, 0), NumSymbols);
+	Chords.Reserve(PendingChords.Num());
+	for (const FPendingChord& PendingChord : PendingChords)
+	{
+		TPair<int32, int32>& Range = ChordRangeBySymbol[PendingChord.Symbol];
+		if (Range.Key == Range.Value)
+		{
+			Range.Key = Chords.Num();
+		}
+		Chords.Add(PendingChord.Chord);
+		Range.Value = Chords.Num();
+	}
+}
+
+void FGASInputComboMatcher::Reset()
+{
+	CompiledCombos.Reset();
+	Actions.Reset();
+	SymbolByAction.Reset();
+	Transitions.Reset();
+	StateOutputs.Reset();
+	OutputLinks.Reset();
+	MaxStepInterval = 0.f;
+	Chords.Reset();
+	ChordRangeBySymbol.Reset();
+}
+
+int32 FGASInputComboMatcher::FindSymbol(const UInputAction* InputAction) const
+{
+	const int32* Symbol = SymbolByAction.Find(InputAction);
+	return Symbol ? *Symbol : INDEX_NONE;
+}
+
+const FGASCompiledInputCombo* FGASInputComboMatcher::OnPressed(FGASInputComboState& State, int32 Symbol, double Time) const
+{
+	const uint64 SymbolBit = uint64(1) << Symbol;
+
+	const TPair<int32, int32>& ChordRange = ChordRangeBySymbol[Symbol];
+	for (int32 ChordIndex = ChordRange.Key; ChordIndex < ChordRange.Value; ++ChordIndex)
+	{
+		const FChord& Chord = Chords[ChordIndex];
+		if ((State.HeldSymbols & Chord.RequiredHeld) == Chord.RequiredHeld)
+		{
+			// The press is used up by the chord, sequences start over
+			const uint64 HeldSymbols = State.HeldSymbols | SymbolBit;
+			State.Reset();
+			State.HeldSymbols = HeldSymbols;
+			return &CompiledCombos[Chord.ComboIndex];
+		}
+	}
+	State.HeldSymbols |= SymbolBit;
+
+	// Too slow for any sequence, start over from this press
+	constexpr int32 MaxSteps = FGASInputComboState::MaxSteps;
+	if (State.NumSteps > 0 && Time - State.StepTimes[(State.NumSteps - 1) % MaxSteps] > MaxStepInterval)
+	{
+		State.SequenceState = 0;
+		State.NumSteps = 0;
+	}
+	State.StepTimes[State.NumSteps % MaxSteps] = Time;
+	++State.NumSteps;
+	State.SequenceState = Transitions[State.SequenceState * Actions.Num() + Symbol];
+
+	// The longest sequence ending here comes first, shorter ones may still match if it was too slow
+	int32 OutputState = StateOutputs[State.SequenceState] != INDEX_NONE ? State.SequenceState : OutputLinks[State.SequenceState];
+	for (; OutputState != INDEX_NONE; OutputState = OutputLinks[OutputState])
+	{
+		const FGASCompiledInputCombo& Combo = CompiledCombos[StateOutputs[OutputState]];
+		if (HasValidTiming(State, Combo))
+		{
+			State.SequenceState = 0;
+			State.NumSteps = 0;
+			return &Combo;
+		}
+	}
+	return nullptr;
+}
+
+void FGASInputComboMatcher::OnReleased(FGASInputComboState& State, int32 Symbol) const
+{
+	State.HeldSymbols &= ~(uint64(1) << Symbol);
+}
+
+bool FGASInputComboMatcher::HasValidTiming(const FGASInputComboState& State, const FGASCompiledInputCombo& Combo)
+{
+	if (State.NumSteps < Combo.NumSteps)
+	{
+		return false;
+	}
+
+	constexpr int32 MaxSteps = FGASInputComboState::MaxSteps;
+	for (uint32 Step = State.NumSteps - Combo.NumSteps + 1; Step < State.NumSteps; ++Step)
+	{
+		if (State.StepTimes[Step % MaxSteps] - State.StepTimes[(Step - 1) % MaxSteps] > Combo.MaxStepInterval)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+SIZE_T FGASInputComboMatcher::GetAllocatedSize() const
+{
+	return CompiledCombos.GetAllocatedSize() + Actions.GetAllocatedSize() + SymbolByAction.GetAllocatedSize()
+		+ Transitions.GetAllocatedSize() + StateOutputs.GetAllocatedSize() + OutputLinks.GetAllocatedSize()
+		+ Chords.GetAllocatedSize() + ChordRangeBySymbol.GetAllocatedSize();
+}
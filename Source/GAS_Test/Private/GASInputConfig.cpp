@@ -2,3 +2,259 @@
 
 
 #include "GASInputConfig.h"
+#include "InputAction.h"
+
+GASInputEventType FEventActionPair::GetEventType(ETriggerEvent TriggerEvent) const
+{
+	switch (TriggerEvent)
+	{
+	case ETriggerEvent::Triggered:
+		return Triggered;
+	case ETriggerEvent::Started:
+		return Started;
+	case ETriggerEvent::Ongoing:
+		return Ongoing;
+	case ETriggerEvent::Canceled:
+		return Canceled;
+	case ETriggerEvent::Completed:
+		return Completed;
+	default:
+		return GASInputEventType::NotApplicable;
+	}
+}
+
+void FEventActionPair::SetEventType(ETriggerEvent TriggerEvent, GASInputEventType EventType)
+{
+	switch (TriggerEvent)
+	{
+	case ETriggerEvent::Triggered:
+		Triggered = EventType;
+		break;
+	case ETriggerEvent::Started:
+		Started = EventType;
+		break;
+	case ETriggerEvent::Ongoing:
+		Ongoing = EventType;
+		break;
+	case ETriggerEvent::Canceled:
+		Canceled = EventType;
+		break;
+	case ETriggerEvent::Completed:
+		Completed = EventType;
+		break;
+	default:
+		break;
+	}
+}
+
+#if WITH_EDITORONLY_DATA
+bool FEventActionPair::UpgradeEventAction()
+{
+	if (EventAction_DEPRECATED.IsEmpty())
+	{
+		return false;
+	}
+
+	for (const TPair<ETriggerEvent, GASInputEventType>& EventPair : EventAction_DEPRECATED)
+	{
+		SetEventType(EventPair.Key, EventPair.Value);
+	}
+	EventAction_DEPRECATED.Empty();
+	return true;
+}
+#endif
+
+void UGASInputConfig::PostLoad()
+{
+	Super::PostLoad();
+
+#if WITH_EDITORONLY_DATA
+	// Assets saved with the trigger event map, they keep loading through it until resaved
+	for (TPair<UInputAction*, FEventActionPairTag>& ActionPair : AbilityInputActions)
+	{
+		for (TPair<FGameplayTag, FEventActionPair>& GameplayTagPair : ActionPair.Value.TaggedAction)
+		{
+			GameplayTagPair.Value.UpgradeEventAction();
+		}
+	}
+#endif
+
+	CompileBindings();
+}
+
+void UGASInputConfig::GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize)
+{
+	Super::GetResourceSizeEx(CumulativeResourceSize);
+
+	SIZE_T Bytes = AbilityInputActions.GetAllocatedSize() + DefaultInputMapping.GetAllocatedSize() + Combos.GetAllocatedSize();
+	for (const TPair<UInputAction*, FEventActionPairTag>& ActionPair : AbilityInputActions)
+	{
+		Bytes += ActionPair.Value.TaggedAction.GetAllocatedSize();
+	}
+	for (const FGASInputCombo& Combo : Combos)
+	{
+		Bytes += Combo.Actions.GetAllocatedSize();
+	}
+
+	Bytes += CompiledBindings.GetAllocatedSize() + BindingRangeByAction.GetAllocatedSize() + BindingIndicesSortedByTag.GetAllocatedSize()
+		+ BindingRangeByTag.GetAllocatedSize() + ComboMatcher.GetAllocatedSize();
+	CumulativeResourceSize.AddDedicatedSystemMemoryBytes(Bytes);
+}
+
+bool UGASInputConfig::NeedsLoadForServer() const
+{
+	return bLoadOnDedicatedServer && Super::NeedsLoadForServer();
+}
+
+#if WITH_EDITOR
+void UGASInputConfig::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	// Recompiled on next use
+	bBindingsCompiled = false;
+}
+#endif
+
+const TArray<FGASInputBinding>& UGASInputConfig::GetCompiledBindings() const
+{
+	if (!bBindingsCompiled)
+	{
+		CompileBindings();
+	}
+	return CompiledBindings;
+}
+
+uint32 UGASInputConfig::GetCompiledBindingsHash() const
+{
+	GetCompiledBindings();
+	return CompiledBindingsHash;
+}
+
+TArrayView<const FGASInputBinding> UGASInputConfig::FindBindingsForAction(const UInputAction* InputAction) const
+{
+	const TArray<FGASInputBinding>& Bindings = GetCompiledBindings();
+	if (const FGASInputBindingRange* Range = BindingRangeByAction.Find(InputAction))
+	{
+		return TArrayView<const FGASInputBinding>(Bindings.GetData() + Range->Start, Range->Num);
+	}
+	return TArrayView<const FGASInputBinding>();
+}
+
+const FGASInputComboMatcher& UGASInputConfig::GetComboMatcher() const
+{
+	GetCompiledBindings();
+	return ComboMatcher;
+}
+
+TArrayView<const int32> UGASInputConfig::FindBindingIndicesForTag(const FGameplayTag& InputTag) const
+{
+	GetCompiledBindings();
+	if (const FGASInputBindingRange* Range = BindingRangeByTag.Find(InputTag))
+	{
+		return TArrayView<const int32>(BindingIndicesSortedByTag.GetData() + Range->Start, Range->Num);
+	}
+	return TArrayView<const int32>();
+}
+
+void UGASInputConfig::CompileBindings() const
+{
+	CompiledBindings.Reset();
+	BindingRangeByAction.Reset();
+	BindingIndicesSortedByTag.Reset();
+	BindingRangeByTag.Reset();
+
+	// Flatten the nested maps, validating each entry once here rather than on every bind
+	for (const TPair<UInputAction*, FEventActionPairTag>& ActionPair : AbilityInputActions)
+	{
+		const UInputAction* InputAction = ActionPair.Key;
+		if (!InputAction)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Skipping null InputAction in %s!"), *GetName());
+			continue;
+		}
+
+		for (const TPair<FGameplayTag, FEventActionPair>& GameplayTagPair : ActionPair.Value.TaggedAction)
+		{
+			if (!GameplayTagPair.Key.IsValid())
+			{
+				UE_LOG(LogTemp, Warning, TEXT("Skipping invalid GameplayTag for InputAction: %s"), *InputAction->GetName());
+				continue;
+			}
+
+			GameplayTagPair.Value.ForEachEventType([this, InputAction, &GameplayTagPair](ETriggerEvent TriggerEvent, GASInputEventType EventType)
+			{
+				FGASInputBinding& Binding = CompiledBindings.AddDefaulted_GetRef();
+				Binding.InputAction = InputAction;
+				Binding.TriggerEvent = TriggerEvent;
+				Binding.EventType = EventType;
+				Binding.InputTag = GameplayTagPair.Key;
+			});
+		}
+	}
+
+	// Sort by action so each action's bindings are contiguous, by name rather than address so recorded indices stay valid
+	CompiledBindings.Sort([](const FGASInputBinding& A, const FGASInputBinding& B)
+	{
+		if (A.InputAction != B.InputAction)
+		{
+			if (A.InputAction->GetFName() != B.InputAction->GetFName())
+			{
+				return A.InputAction->GetFName().LexicalLess(B.InputAction->GetFName());
+			}
+			return A.InputAction->GetPathName() < B.InputAction->GetPathName();
+		}
+		if (A.InputTag != B.InputTag)
+		{
+			return A.InputTag.GetTagName().LexicalLess(B.InputTag.GetTagName());
+		}
+		return static_cast<uint8>(A.TriggerEvent) < static_cast<uint8>(B.TriggerEvent);
+	});
+
+	// Hashes names rather than FName or pointer hashes, which differ between sessions
+	CompiledBindingsHash = 0;
+	for (const FGASInputBinding& Binding : CompiledBindings)
+	{
+		CompiledBindingsHash = HashCombine(CompiledBindingsHash, FCrc::StrCrc32(*Binding.InputAction->GetPathName()));
+		CompiledBindingsHash = HashCombine(CompiledBindingsHash, FCrc::StrCrc32(*Binding.InputTag.ToString()));
+		CompiledBindingsHash = HashCombine(CompiledBindingsHash, static_cast<uint32>(Binding.TriggerEvent) << 8 | static_cast<uint32>(Binding.EventType));
+	}
+
+	// Recorded combo inputs refer to the combo matcher's symbols, which follow the combos
+	for (const FGASInputCombo& Combo : Combos)
+	{
+		for (const UInputAction* InputAction : Combo.Actions)
+		{
+			CompiledBindingsHash = HashCombine(CompiledBindingsHash, FCrc::StrCrc32(*GetPathNameSafe(InputAction)));
+		}
+		CompiledBindingsHash = HashCombine(CompiledBindingsHash, FCrc::StrCrc32(*Combo.InputTag.ToString()));
+		CompiledBindingsHash = HashCombine(CompiledBindingsHash, static_cast<uint32>(Combo.Type) << 8 | static_cast<uint32>(Combo.EventType));
+	}
+
+	for (int32 Index = 0; Index < CompiledBindings.Num(); ++Index)
+	{
+		FGASInputBindingRange& Range = BindingRangeByAction.FindOrAdd(CompiledBindings[Index].InputAction, FGASInputBindingRange{ Index, 0 });
+		++Range.Num;
+	}
+
+	// Secondary index, sorted by tag so each tag's bindings are contiguous
+	BindingIndicesSortedByTag.Reserve(CompiledBindings.Num());
+	for (int32 Index = 0; Index < CompiledBindings.Num(); ++Index)
+	{
+		BindingIndicesSortedByTag.Add(Index);
+	}
+	BindingIndicesSortedByTag.StableSort([this](const int32 A, const int32 B)
+	{
+		return CompiledBindings[A].InputTag.GetTagName().LexicalLess(CompiledBindings[B].InputTag.GetTagName());
+	});
+
+	for (int32 Index = 0; Index < BindingIndicesSortedByTag.Num(); ++Index)
+	{
+		FGASInputBindingRange& Range = BindingRangeByTag.FindOrAdd(CompiledBindings[BindingIndicesSortedByTag[Index]].InputTag, FGASInputBindingRange{ Index, 0 });
+		++Range.Num;
+	}
+
+	ComboMatcher.Compile(Combos, this);
+
+	bBindingsCompiled = true;
+}
@@ -0,0 +1,257 @@
+﻿#include "GASInputRecording.h"
+#include "AbilityInputHandler.h"
+#include "InputAction.h"
+#include "GameFramework/Pawn.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+#if !UE_BUILD_SHIPPING
+
+namespace GASInputRecording
+{
+	/** 'GASI' */
+	static constexpr uint32 FileMagic = 0x49534147;
+	/** 2 added the hash of the binding table, 3 the combo inputs. */
+	static constexpr uint32 FileVersion = 3;
+
+	/** Header then inputs, frames as deltas and the input type in the low two bits of the binding index. */
+	static void Serialize(FArchive& Ar, FGASInputRecording& Recording)
+	{
+		FString InputConfigPath = Recording.InputConfigPath.ToString();
+		Ar << InputConfigPath;
+		Ar << Recording.NumBindings;
+		Ar << Recording.BindingsHash;
+		Ar << Recording.NumFrames;
+
+		uint32 NumInputs = Recording.Inputs.Num();
+		Ar.SerializeIntPacked(NumInputs);
+
+		if (Ar.IsLoading())
+		{
+			Recording.InputConfigPath = FSoftObjectPath(InputConfigPath);
+			Recording.Inputs.SetNum(NumInputs);
+		}
+
+		uint32 PreviousFrame = 0;
+		for (FGASRecordedInput& Input : Recording.Inputs)
+		{
+			uint32 FrameDelta = Input.Frame - PreviousFrame;
+			uint32 PackedBinding = (static_cast<uint32>(Input.BindingIndex) << 2) | static_cast<uint32>(Input.Type);
+			Ar.SerializeIntPacked(FrameDelta);
+			Ar.SerializeIntPacked(PackedBinding);
+
+			if (Ar.IsLoading())
+			{
+				Input.Frame = PreviousFrame + FrameDelta;
+				Input.BindingIndex = static_cast<int32>(PackedBinding >> 2);
+				Input.Type = static_cast<EGASRecordedInputType>(PackedBinding & 3);
+			}
+			if (Input.Type == EGASRecordedInputType::TriggeredValue)
+			{
+				Ar << Input.Value;
+			}
+			PreviousFrame = Input.Frame;
+		}
+	}
+}
+
+bool FGASInputRecording::SaveToFile(const FString& Filename) const
+{
+	TArray<uint8> Bytes;
+	FMemoryWriter Writer(Bytes);
+
+	uint32 Magic = GASInputRecording::FileMagic;
+	uint32 Version = GASInputRecording::FileVersion;
+	Writer << Magic << Version;
+	GASInputRecording::Serialize(Writer, const_cast<FGASInputRecording&>(*this));
+
+	return FFileHelper::SaveArrayToFile(Bytes, *Filename);
+}
+
+bool FGASInputRecording::LoadFromFile(const FString& Filename)
+{
+	TArray<uint8> Bytes;
+	if (!FFileHelper::LoadFileToArray(Bytes, *Filename))
+	{
+		return false;
+	}
+
+	FMemoryReader Reader(Bytes);
+	uint32 Magic = 0;
+	uint32 Version = 0;
+	Reader << Magic << Version;
+	if (Magic != GASInputRecording::FileMagic || Version != GASInputRecording::FileVersion)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s is not a GAS input recording, or of an unsupported version. Recordings older than version %u must be recorded again."),
+			*Filename, GASInputRecording::FileVersion);
+		return false;
+	}
+
+	GASInputRecording::Serialize(Reader, *this);
+	return !Reader.IsError();
+}
+
+bool FGASInputRecording::IsCompatibleWith(const UGASInputConfig* InputConfig) const
+{
+	return InputConfig && InputConfig->GetCompiledBindings().Num() == NumBindings && InputConfig->GetCompiledBindingsHash() == BindingsHash;
+}
+
+void FGASInputRecording::Replay(UAbilityInputHandler& Handler, const FGASRecordedInput& Input)
+{
+	if (Input.Type == EGASRecordedInputType::ComboPressed || Input.Type == EGASRecordedInputType::ComboReleased)
+	{
+		const TConstArrayView<const UInputAction*> ComboActions = Handler.InputConfig->GetComboMatcher().GetActions();
+		if (ComboActions.IsValidIndex(Input.BindingIndex))
+		{
+			Handler.ComboInput(ComboActions[Input.BindingIndex], Input.Type == EGASRecordedInputType::ComboPressed);
+		}
+		return;
+	}
+
+	const TArray<FGASInputBinding>& Bindings = Handler.InputConfig->GetCompiledBindings();
+	if (!Bindings.IsValidIndex(Input.BindingIndex))
+	{
+		return;
+	}
+
+	const FGASInputBinding& Binding = Bindings[Input.BindingIndex];
+	if (Input.Type == EGASRecordedInputType::TriggeredValue)
+	{
+		Handler.TriggeredInput(Binding.InputAction, FInputActionValue(Binding.InputAction->ValueType, FVector(Input.Value)));
+		return;
+	}
+
+	switch (Binding.EventType)
+	{
+	case GASInputEventType::GameplayAbility:
+		Handler.AbilityInput(Binding.InputTag, Binding.TriggerEvent);
+		break;
+	case GASInputEventType::GameplayEvent:
+		Handler.EventInput(Binding.InputTag, Binding.TriggerEvent);
+		break;
+	case GASInputEventType::GameplayDynamic:
+		Handler.DynamicInput(Binding.InputTag, Binding.TriggerEvent);
+		break;
+	default:
+		break;
+	}
+}
+
+namespace GASInputRecorder
+{
+	bool bIsRecording = false;
+
+	static FGASInputRecording Recording;
+	static uint64 StartFrame = 0;
+	static FString OutputPath;
+
+	/** Only the local player's input is recorded, replays and AI go through the same handlers. */
+	static bool ShouldRecord(const UAbilityInputHandler& Handler)
+	{
+		const APawn* Pawn = Cast<APawn>(Handler.GetOwner());
+		if (!Pawn || !Pawn->IsLocallyControlled() || !Pawn->IsPlayerControlled() || !Handler.InputConfig)
+		{
+			return false;
+		}
+
+		// The first input fixes the config the binding indices refer to
+		if (Recording.NumBindings == 0)
+		{
+			Recording.InputConfigPath = FSoftObjectPath(Handler.InputConfig.Get());
+			Recording.NumBindings = Handler.InputConfig->GetCompiledBindings().Num();
+			Recording.BindingsHash = Handler.InputConfig->GetCompiledBindingsHash();
+		}
+		return Recording.InputConfigPath == FSoftObjectPath(Handler.InputConfig.Get());
+	}
+
+	static void AddInput(int32 BindingIndex, EGASRecordedInputType Type, const FVector& Value)
+	{
+		FGASRecordedInput& Input = Recording.Inputs.AddDefaulted_GetRef();
+		Input.Frame = static_cast<uint32>(GFrameCounter - StartFrame);
+		Input.BindingIndex = BindingIndex;
+		Input.Type = Type;
+		Input.Value = FVector3f(Value);
+	}
+
+	void RecordTagInput(const UAbilityInputHandler& Handler, const FGameplayTag& InputTag, ETriggerEvent TriggerEvent, GASInputEventType EventType)
+	{
+		if (!ShouldRecord(Handler))
+		{
+			return;
+		}
+
+		// Tag and trigger event are enough to replay the input, any binding sending them will do
+		const TArray<FGASInputBinding>& Bindings = Handler.InputConfig->GetCompiledBindings();
+		for (const int32 BindingIndex : Handler.InputConfig->FindBindingIndicesForTag(InputTag))
+		{
+			const FGASInputBinding& Binding = Bindings[BindingIndex];
+			if (Binding.EventType == EventType && (TriggerEvent == ETriggerEvent::None || Binding.TriggerEvent == TriggerEvent))
+			{
+				AddInput(BindingIndex, EGASRecordedInputType::Tag, FVector::ZeroVector);
+				return;
+			}
+		}
+	}
+
+	void RecordTriggeredValue(const UAbilityInputHandler& Handler, const UInputAction* InputAction, const FVector& Value)
+	{
+		if (!ShouldRecord(Handler))
+		{
+			return;
+		}
+
+		const TArrayView<const FGASInputBinding> ActionBindings = Handler.InputConfig->FindBindingsForAction(InputAction);
+		if (!ActionBindings.IsEmpty())
+		{
+			AddInput(static_cast<int32>(ActionBindings.GetData() - Handler.InputConfig->GetCompiledBindings().GetData()), EGASRecordedInputType::TriggeredValue, Value);
+		}
+	}
+
+	void RecordComboInput(const UAbilityInputHandler& Handler, int32 Symbol, bool bPressed)
+	{
+		if (ShouldRecord(Handler))
+		{
+			AddInput(Symbol, bPressed ? EGASRecordedInputType::ComboPressed : EGASRecordedInputType::ComboReleased, FVector::ZeroVector);
+		}
+	}
+}
+
+static FAutoConsoleCommand GASInputRecordCommand(
+	TEXT("GAS.Input.Record"),
+	TEXT("Starts recording the local player's ability input, or stops and saves the recording if already recording.\n")
+	TEXT("Usage: GAS.Input.Record [Out=File.gasinput]. Out defaults to the profiling directory, replay it with GAS.Benchmark Replay=File."),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		using namespace GASInputRecorder;
+
+		if (bIsRecording)
+		{
+			bIsRecording = false;
+			Recording.NumFrames = static_cast<uint32>(GFrameCounter - StartFrame);
+			if (Recording.SaveToFile(OutputPath))
+			{
+				UE_LOG(LogTemp, Log, TEXT("GAS.Input.Record: wrote %d inputs over %u frames to %s"), Recording.Inputs.Num(), Recording.NumFrames, *OutputPath);
+			}
+			else
+			{
+				UE_LOG(LogTemp, Error, TEXT("GAS.Input.Record: could not write %s"), *OutputPath);
+			}
+			Recording = FGASInputRecording();
+			return;
+		}
+
+		if (!FParse::Value(*FString::Join(Args, TEXT(" ")), TEXT("Out="), OutputPath))
+		{
+			OutputPath = FPaths::ProfilingDir() / FString::Printf(TEXT("GASInput-%s.gasinput"), *FDateTime::Now().ToString());
+		}
+
+		Recording = FGASInputRecording();
+		StartFrame = GFrameCounter;
+		bIsRecording = true;
+		UE_LOG(LogTemp, Log, TEXT("GAS.Input.Record: recording, run the command again to stop."));
+	}));
+
+#endif // !UE_BUILD_SHIPPING
@@ -0,0 +1,92 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "GASInputConfig.h"
+
+#if !UE_BUILD_SHIPPING
+
+class UAbilityInputHandler;
+
+/** How a recorded input reached UAbilityInputHandler. */
+enum class EGASRecordedInputType : uint8
+{
+	/** A tag dispatched by the binding's event type. */
+	Tag,
+
+	/** A Triggered value routed to triggered abilities. */
+	TriggeredValue,
+
+	/** A press of a combo action, the combo matcher completes combos again when replayed. */
+	ComboPressed,
+
+	/** A release of a combo action, ending chords. */
+	ComboReleased,
+};
+
+/** One input that reached UAbilityInputHandler, identified by its binding in the input config's compiled binding table. */
+struct FGASRecordedInput
+{
+	/** Frames since the recording started. */
+	uint32 Frame = 0;
+
+	/**
+	 * Index in UGASInputConfig::GetCompiledBindings, which gives the input action, trigger event, tag and dispatch type.
+	 * For combo inputs, the combo matcher's symbol of the action.
+	 */
+	int32 BindingIndex = INDEX_NONE;
+
+	EGASRecordedInputType Type = EGASRecordedInputType::Tag;
+
+	/** Value of the input action, only kept for triggered values. */
+	FVector3f Value = FVector3f::ZeroVector;
+};
+
+/**
+ * A stream of inputs recorded from the local player's UAbilityInputHandler, saved as a compact binary file:
+ * a header naming the input config, then every input with its frame delta and binding index packed.
+ */
+struct FGASInputRecording
+{
+	/** Input config the binding indices refer to. */
+	FSoftObjectPath InputConfigPath;
+
+	/** Number of compiled bindings of the config when recorded. */
+	int32 NumBindings = 0;
+
+	/** UGASInputConfig::GetCompiledBindingsHash of the config when recorded, replaying against a different table is refused. */
+	uint32 BindingsHash = 0;
+
+	/** Length of the recording in frames. */
+	uint32 NumFrames = 0;
+
+	/** Inputs sorted by frame. */
+	TArray<FGASRecordedInput> Inputs;
+
+	bool SaveToFile(const FString& Filename) const;
+	bool LoadFromFile(const FString& Filename);
+
+	/** Returns true if the indices of this recording can be replayed through the given config, which has the same binding table. */
+	bool IsCompatibleWith(const UGASInputConfig* InputConfig) const;
+
+	/** Feeds one input to a handler the way the input component would, bypassing input devices. */
+	static void Replay(UAbilityInputHandler& Handler, const FGASRecordedInput& Input);
+};
+
+namespace GASInputRecorder
+{
+	/** True while GAS.Input.Record is capturing. */
+	extern bool bIsRecording;
+
+	inline bool IsRecording() { return bIsRecording; }
+
+	/** Captures a tag input reaching the handler, if it is the local player's. */
+	void RecordTagInput(const UAbilityInputHandler& Handler, const FGameplayTag& InputTag, ETriggerEvent TriggerEvent, GASInputEventType EventType);
+
+	/** Captures a Triggered value reaching the handler, if it is the local player's. */
+	void RecordTriggeredValue(const UAbilityInputHandler& Handler, const UInputAction* InputAction, const FVector& Value);
+
+	/** Captures the press or release of a combo action, by its symbol in the config's combo matcher. */
+	void RecordComboInput(const UAbilityInputHandler& Handler, int32 Symbol, bool bPressed);
+}
+
+#endif // !UE_BUILD_SHIPPING
@@ -0,0 +1,142 @@
+﻿#include "GASInputTelemetry.h"
+#include "HAL/IConsoleManager.h"
+
+UE_TRACE_CHANNEL_DEFINE(GASInputChannel)
+
+UE_TRACE_EVENT_BEGIN(GASInput, InputDispatch)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(double, LatencyMs)
+	UE_TRACE_EVENT_FIELD(uint8, EventType)
+	UE_TRACE_EVENT_FIELD(uint8, TriggerEvent)
+	UE_TRACE_EVENT_FIELD(uint8, Result)
+	UE_TRACE_EVENT_FIELD(UE::Trace::WideString, InputTag)
+	UE_TRACE_EVENT_FIELD(UE::Trace::WideString, FailureReason)
+UE_TRACE_EVENT_END()
+
+const TCHAR* LexToString(EGASInputResult Result)
+{
+	switch (Result)
+	{
+	case EGASInputResult::Activated:		return TEXT("Activated");
+	case EGASInputResult::EventSent:		return TEXT("EventSent");
+	case EGASInputResult::Coalesced:		return TEXT("Coalesced");
+	case EGASInputResult::Buffered:			return TEXT("Buffered");
+	case EGASInputResult::BufferExtended:	return TEXT("BufferExtended");
+	case EGASInputResult::Failed:			return TEXT("Failed");
+	case EGASInputResult::Expired:			return TEXT("Expired");
+	case EGASInputResult::NoAbilitySystem:	return TEXT("NoAbilitySystem");
+	default:								return TEXT("Unknown");
+	}
+}
+
+#if !UE_BUILD_SHIPPING
+
+namespace GASInputTelemetry
+{
+	/** Rolling statistics of one input tag. */
+	struct FTagHistory
+	{
+		/** Latencies of the last NumLatencySamples successful inputs, in milliseconds. */
+		static constexpr int32 NumLatencySamples = 256;
+		TStaticArray<float, NumLatencySamples> LatenciesMs;
+		int32 NumLatencies = 0;
+		int32 NextLatency = 0;
+
+		int32 ResultCounts[static_cast<int32>(EGASInputResult::Num)] = {};
+		TMap<FGameplayTag, int32> FailureReasonCounts;
+	};
+
+	static TMap<FGameplayTag, FTagHistory> TagHistories;
+
+	static void AddToHistory(const FGASInputSample& Sample)
+	{
+		FTagHistory& History = TagHistories.FindOrAdd(Sample.InputTag);
+		++History.ResultCounts[static_cast<int32>(Sample.Result)];
+
+		if (Sample.Result == EGASInputResult::Activated || Sample.Result == EGASInputResult::EventSent)
+		{
+			History.LatenciesMs[History.NextLatency] = static_cast<float>(Sample.LatencySeconds * 1000.0);
+			History.NextLatency = (History.NextLatency + 1) % FTagHistory::NumLatencySamples;
+			History.NumLatencies = FMath::Min(History.NumLatencies + 1, FTagHistory::NumLatencySamples);
+		}
+		else if (Sample.FailureReason.IsValid())
+		{
+			++History.FailureReasonCounts.FindOrAdd(Sample.FailureReason);
+		}
+	}
+
+	static float Percentile(const TArray<float>& SortedValues, float Fraction)
+	{
+		const int32 Index = FMath::Clamp(FMath::CeilToInt32(Fraction * SortedValues.Num()) - 1, 0, SortedValues.Num() - 1);
+		return SortedValues[Index];
+	}
+
+	static FAutoConsoleCommand DumpLatencyCommand(
+		TEXT("GAS.Input.DumpLatency"),
+		TEXT("Logs the p50/p95/p99 input-to-activation latency of the last inputs and the result and failure reason histograms of each input tag."),
+		FConsoleCommandDelegate::CreateLambda([]()
+		{
+			if (TagHistories.IsEmpty())
+			{
+				UE_LOG(LogTemp, Log, TEXT("GAS.Input.DumpLatency: no input recorded."));
+				return;
+			}
+
+			TArray<float> SortedLatencies;
+			for (const TPair<FGameplayTag, FTagHistory>& TagHistory : TagHistories)
+			{
+				const FTagHistory& History = TagHistory.Value;
+
+				FString Line = FString::Printf(TEXT("%s:"), *TagHistory.Key.ToString());
+				if (History.NumLatencies > 0)
+				{
+					SortedLatencies.Reset();
+					SortedLatencies.Append(History.LatenciesMs.GetData(), History.NumLatencies);
+					SortedLatencies.Sort();
+					Line += FString::Printf(TEXT(" latency ms p50 %.3f p95 %.3f p99 %.3f (%d samples) |"),
+						Percentile(SortedLatencies, 0.5f), Percentile(SortedLatencies, 0.95f), Percentile(SortedLatencies, 0.99f), History.NumLatencies);
+				}
+
+				for (int32 ResultIndex = 0; ResultIndex < static_cast<int32>(EGASInputResult::Num); ++ResultIndex)
+				{
+					if (History.ResultCounts[ResultIndex] > 0)
+					{
+						Line += FString::Printf(TEXT(" %s %d"), LexToString(static_cast<EGASInputResult>(ResultIndex)), History.ResultCounts[ResultIndex]);
+					}
+				}
+
+				for (const TPair<FGameplayTag, int32>& FailureReason : History.FailureReasonCounts)
+				{
+					Line += FString::Printf(TEXT(" [%s %d]"), *FailureReason.Key.ToString(), FailureReason.Value);
+				}
+
+				UE_LOG(LogTemp, Log, TEXT("%s"), *Line);
+			}
+		}));
+
+	static FAutoConsoleCommand ResetLatencyCommand(
+		TEXT("GAS.Input.ResetLatency"),
+		TEXT("Clears the input latency statistics dumped by GAS.Input.DumpLatency."),
+		FConsoleCommandDelegate::CreateLambda([]()
+		{
+			TagHistories.Reset();
+		}));
+}
+
+#endif // !UE_BUILD_SHIPPING
+
+void GASInputTelemetry::Record(const FGASInputSample& Sample)
+{
+	UE_TRACE_LOG(GASInput, InputDispatch, GASInputChannel)
+		<< InputDispatch.Cycle(FPlatformTime::Cycles64())
+		<< InputDispatch.LatencyMs(Sample.LatencySeconds * 1000.0)
+		<< InputDispatch.EventType(static_cast<uint8>(Sample.EventType))
+		<< InputDispatch.TriggerEvent(static_cast<uint8>(Sample.TriggerEvent))
+		<< InputDispatch.Result(static_cast<uint8>(Sample.Result))
+		<< InputDispatch.InputTag(*Sample.InputTag.ToString())
+		<< InputDispatch.FailureReason(*Sample.FailureReason.ToString());
+
+#if !UE_BUILD_SHIPPING
+	AddToHistory(Sample);
+#endif
+}
@@ -0,0 +1,50 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayTagContainer.h"
+#include "GASInputConfig.h"
+#include "Trace/Trace.h"
+
+/** Unreal Insights channel of the input dispatch events, enable with -trace=GASInput. */
+UE_TRACE_CHANNEL_EXTERN(GASInputChannel);
+
+/** What happened to an input that reached UAbilityInputHandler. */
+enum class EGASInputResult : uint8
+{
+	Activated,
+	EventSent,
+	Coalesced,
+	Buffered,
+	BufferExtended,
+	Failed,
+	Expired,
+	NoAbilitySystem,
+
+	Num
+};
+
+const TCHAR* LexToString(EGASInputResult Result);
+
+/** One dispatched input, see GASInputTelemetry::Record. */
+struct FGASInputSample
+{
+	FGameplayTag InputTag;
+	GASInputEventType EventType = GASInputEventType::NotApplicable;
+	ETriggerEvent TriggerEvent = ETriggerEvent::None;
+	EGASInputResult Result = EGASInputResult::Failed;
+
+	/** First tag the ASC reported when the activation failed, e.g. the cooldown or blocked failure tag of the ability system globals. */
+	FGameplayTag FailureReason;
+
+	/** Seconds from the input reaching the handler to the ability activating or the event being handled. */
+	double LatencySeconds = 0.0;
+};
+
+namespace GASInputTelemetry
+{
+	/**
+	 * Emits the sample on the GASInput trace channel, and outside shipping builds adds it to the rolling per tag statistics
+	 * dumped by GAS.Input.DumpLatency. Game thread only.
+	 */
+	void Record(const FGASInputSample& Sample);
+}
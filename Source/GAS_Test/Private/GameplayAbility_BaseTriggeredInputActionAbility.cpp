@@ -1,7 +1,6 @@
 ﻿#include "GameplayAbility_BaseTriggeredInputActionAbility.h"
 #include "AbilityInputHandler.h"
-#include "EnhancedInputComponent.h"
-#include "GASInputConfig.h"
+#include "InputAction.h"
 
 UGameplayAbility_BaseTriggeredInputActionAbility::UGameplayAbility_BaseTriggeredInputActionAbility(const FObjectInitializer& ObjectInitializer)
     : Super(ObjectInitializer), bCancelAbilityOnInputReleased(true)
@@ -27,59 +26,10 @@ void UGameplayAbility_BaseTriggeredInputActionAbility::ActivateAbility(
         return;
     }
 
-    // Try to cast the input component once
-    EnhancedInputComponent = Cast<UEnhancedInputComponent>(PlayerCharacter->InputComponent);
-    if (!EnhancedInputComponent)
+    // The handler keeps a Triggered binding for each action of its config, and routes the values to registered abilities
+    if (UAbilityInputHandler* InputHandler = FindAbilityInputHandler(PlayerCharacter))
     {
-        return;  // Early return if input component is not found
-    }
-
-    // Get the ability input handler
-    const UAbilityInputHandler* AbilityInputHandler = PlayerCharacter->FindComponentByClass<UAbilityInputHandler>();
-    if (!AbilityInputHandler || !AbilityInputHandler->InputConfig) 
-    {
-        return;  // Early return if input config is invalid
-    }
-
-    // Get input mappings
-    const TMap<UInputAction*, FEventActionPairTag>& InputAbilities = AbilityInputHandler->InputConfig->AbilityInputActions;
-
-    // Iterate over input actions
-    for (const TPair<UInputAction*, FEventActionPairTag>& ActionPair : InputAbilities)
-    {
-        UInputAction* InputAction = ActionPair.Key;
-        const FEventActionPairTag& EventPairTag = ActionPair.Value;
-
-        // Iterate over tagged actions
-        for (const TPair<FGameplayTag, FEventActionPair>& TaggedActionPair : EventPairTag.TaggedAction)
-        {
-            FGameplayTag GameplayTag = TaggedActionPair.Key;
-            const FEventActionPair& EventAction = TaggedActionPair.Value;
-
-            // Iterate over event-action mappings
-            for (const TPair<ETriggerEvent, GASInputEventType>& EventMapping : EventAction.EventAction)
-            {
-                ETriggerEvent TriggerEvent = EventMapping.Key;
-
-                // Check if the gameplay tag matches the ability's tag
-                if (GetAssetTags().HasTagExact(GameplayTag) && TriggerEvent == ETriggerEvent::Triggered)
-                {
-                    // Bind input action when triggered
-                    const FEnhancedInputActionEventBinding& TriggeredEventBinding =
-                        EnhancedInputComponent->BindAction(InputAction, ETriggerEvent::Triggered, this, 
-                        &UGameplayAbility_BaseTriggeredInputActionAbility::OnTriggeredInputAction);
-
-                    // Store event handle to track bindings
-                    const uint32 TriggeredEventHandle = TriggeredEventBinding.GetHandle();
-                    TriggeredEventHandles.AddUnique(TriggeredEventHandle);
-
-                    UE_LOG(LogTemp, Log, TEXT("Bound Input: %s | Tag: %s | Trigger Event: Triggered"), 
-                        *InputAction->GetName(), *GameplayTag.ToString());
-
-                    bSuccess = true;
-                }
-            }
-        }
+        bSuccess = InputHandler->RegisterTriggeredAbility(this);
     }
 
     // If successfully bound, commit ability
@@ -103,18 +53,22 @@ void UGameplayAbility_BaseTriggeredInputActionAbility::EndAbility(
 {
     Super::EndAbility(Handle, ActorInfo, ActivationInfo, bReplicateEndAbility, bWasCancelled);
 
-    if (EnhancedInputComponent)
+    if (UAbilityInputHandler* InputHandler = AbilityInputHandler.Get())
     {
-        // Unbind the actions and reset input component
-        for (const uint32 EventHandle : TriggeredEventHandles)
-        {
-            EnhancedInputComponent->RemoveBindingByHandle(EventHandle);
-        }
+        InputHandler->UnregisterTriggeredAbility(this);
+    }
+}
 
-        EnhancedInputComponent = nullptr;
+UAbilityInputHandler* UGameplayAbility_BaseTriggeredInputActionAbility::FindAbilityInputHandler(const APawn* Avatar)
+{
+    UAbilityInputHandler* InputHandler = AbilityInputHandler.Get();
+    if (!InputHandler || InputHandler->GetOwner() != Avatar)
+    {
+        InputHandler = Avatar->FindComponentByClass<UAbilityInputHandler>();
+        AbilityInputHandler = InputHandler;
     }
 
-    TriggeredEventHandles.Reset();
+    return InputHandler;
 }
 
 void UGameplayAbility_BaseTriggeredInputActionAbility::InputReleased(
@@ -0,0 +1,54 @@
+﻿#include "AbilityInputHandler.h"
+#include "AbilityStateTagHandler.h"
+#include "GASAbilitySystemComponent.h"
+#include "GASAllocationCounter.h"
+#include "GASInputConfig.h"
+#include "GASTestPawn.h"
+#include "GASTestUtilities.h"
+#include "Misc/AutomationTest.h"
+#include "UObject/StrongObjectPtr.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGASInputDispatchAllocationTest, "GAS_Test.Input.DispatchAllocations",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FGASInputDispatchAllocationTest::RunTest(const FString& Parameters)
+{
+	FGASTestWorld TestWorld;
+	const TStrongObjectPtr<UGASInputConfig> InputConfig(GASTest::CreateInputConfig());
+	const TStrongObjectPtr<UAbilityStateCheckObjects> StateChecks(GASTest::CreateStateChecks());
+	const AGASTestPawn* Pawn = GASTest::SpawnPawn(TestWorld.GetWorld(), InputConfig.Get(), StateChecks.Get());
+	if (!TestNotNull(TEXT("Test pawn"), Pawn))
+	{
+		return false;
+	}
+
+	// The first action sends its tag as ability input, it must reach an activation rather than fail early
+	const FGameplayTag AbilityInputTag = GASTest::GetInputTag(0);
+	if (!TestTrue(TEXT("Instant ability granted"), GASTest::GrantInstantAbility(*Pawn->AbilitySystem, AbilityInputTag).IsValid()))
+	{
+		return false;
+	}
+
+	int32 NumActivations = 0;
+	const FDelegateHandle ActivatedHandle = Pawn->AbilitySystem->AbilityActivatedCallbacks.AddLambda([&NumActivations](UGameplayAbility*)
+	{
+		++NumActivations;
+	});
+
+	constexpr int32 NumInputs = 10000;
+	uint64 NumAllocations = 0;
+	const bool bDispatched = GASDispatchInputBurst(*Pawn->InputHandler, NumInputs, NumAllocations);
+	Pawn->AbilitySystem->AbilityActivatedCallbacks.Remove(ActivatedHandle);
+	if (!TestTrue(TEXT("Inputs dispatched"), bDispatched))
+	{
+		return false;
+	}
+
+	TestTrue(FString::Printf(TEXT("Abilities activated by %s (%d activations)"), *AbilityInputTag.ToString(), NumActivations), NumActivations > 0);
+	TestEqual(FString::Printf(TEXT("Heap allocations over %d inputs"), NumInputs), NumAllocations, uint64(0));
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,13 @@
+﻿#include "GASTestAbility.h"
+
+UGASTestInstantAbility::UGASTestInstantAbility()
+{
+	// Instanced once when granted, so activating it doesn't create an object
+	InstancingPolicy = EGameplayAbilityInstancingPolicy::InstancedPerActor;
+}
+
+void UGASTestInstantAbility::ActivateAbility(const FGameplayAbilitySpecHandle Handle, const FGameplayAbilityActorInfo* ActorInfo,
+	const FGameplayAbilityActivationInfo ActivationInfo, const FGameplayEventData* TriggerEventData)
+{
+	EndAbility(Handle, ActorInfo, ActivationInfo, false, false);
+}
@@ -0,0 +1,21 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "Abilities/GameplayAbility.h"
+#include "GASTestAbility.generated.h"
+
+/**
+ * Ability that ends as soon as it activates, with no cost, cooldown or tags of its own. Granted to test pawns so their
+ * inputs go through a real activation.
+ */
+UCLASS(NotBlueprintable, HideDropdown)
+class UGASTestInstantAbility : public UGameplayAbility
+{
+	GENERATED_BODY()
+
+public:
+	UGASTestInstantAbility();
+
+	virtual void ActivateAbility(const FGameplayAbilitySpecHandle Handle, const FGameplayAbilityActorInfo* ActorInfo,
+		const FGameplayAbilityActivationInfo ActivationInfo, const FGameplayEventData* TriggerEventData) override;
+};
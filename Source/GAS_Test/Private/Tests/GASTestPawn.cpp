@@ -0,0 +1,11 @@
+﻿#include "GASTestPawn.h"
+#include "AbilityInputHandler.h"
+#include "AbilityStateTagHandler.h"
+#include "GASAbilitySystemComponent.h"
+
+AGASTestPawn::AGASTestPawn()
+{
+	AbilitySystem = CreateDefaultSubobject<UGASAbilitySystemComponent>(TEXT("AbilitySystem"));
+	InputHandler = CreateDefaultSubobject<UAbilityInputHandler>(TEXT("InputHandler"));
+	StateTagHandler = CreateDefaultSubobject<UAbilityStateTagHandler>(TEXT("StateTagHandler"));
+}
@@ -0,0 +1,31 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Pawn.h"
+#include "GASTestPawn.generated.h"
+
+class UAbilityInputHandler;
+class UAbilityStateTagHandler;
+class UGASAbilitySystemComponent;
+
+/**
+ * Bare pawn carrying an ability system, an input handler and a state tag handler, spawned by the automation tests and
+ * benchmarks. Its handlers are given their input config and state checks before it finishes spawning.
+ */
+UCLASS(NotBlueprintable, NotPlaceable, Transient, HideDropdown)
+class AGASTestPawn : public APawn
+{
+	GENERATED_BODY()
+
+public:
+	AGASTestPawn();
+
+	UPROPERTY(VisibleAnywhere)
+	TObjectPtr<UGASAbilitySystemComponent> AbilitySystem;
+
+	UPROPERTY(VisibleAnywhere)
+	TObjectPtr<UAbilityInputHandler> InputHandler;
+
+	UPROPERTY(VisibleAnywhere)
+	TObjectPtr<UAbilityStateTagHandler> StateTagHandler;
+};
@@ -0,0 +1,13 @@
+﻿#include "GASTestStateCheck.h"
+
+UGASTestStateCheck_Alternating::UGASTestStateCheck_Alternating()
+{
+	// Only reads the frame counter and the owner's id
+	bThreadSafe = true;
+}
+
+bool UGASTestStateCheck_Alternating::Evaluate(const FAbilityStateCheckContext& Context)
+{
+	const uint64 Offset = Context.Owner ? Context.Owner->GetUniqueID() : 0;
+	return (GFrameCounter + Offset) / Period % 2 == 0;
+}
@@ -0,0 +1,23 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "AbilityStateCheck_Base.h"
+#include "GASTestStateCheck.generated.h"
+
+/**
+ * Passes and fails in turn every few frames, offset by owner so the handlers of a batch don't all flip on the same frame.
+ * Gives the benchmarks state tags to add, remove and replicate on test pawns that never move.
+ */
+UCLASS(NotBlueprintable, HideDropdown)
+class UGASTestStateCheck_Alternating : public UAbilityStateCheck_Base
+{
+	GENERATED_BODY()
+
+public:
+	UGASTestStateCheck_Alternating();
+
+	virtual bool Evaluate(const FAbilityStateCheckContext& Context) override;
+
+	/** Frames between two changes of the result. */
+	static constexpr uint64 Period = 4;
+};
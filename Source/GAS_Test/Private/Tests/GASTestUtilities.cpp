@@ -0,0 +1,103 @@
+﻿#include "GASTestUtilities.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "AbilityInputHandler.h"
+#include "AbilityStateCheck_Native.h"
+#include "AbilityStateTagHandler.h"
+#include "AbilitySystemComponent.h"
+#include "GASInputConfig.h"
+#include "GASTestAbility.h"
+#include "GASTestPawn.h"
+#include "GASTestStateCheck.h"
+#include "InputAction.h"
+#include "NativeGameplayTags.h"
+
+UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_GASTest_Input_0, "GASTest.Input.0");
+UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_GASTest_Input_1, "GASTest.Input.1");
+UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_GASTest_Input_2, "GASTest.Input.2");
+UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_GASTest_Input_3, "GASTest.Input.3");
+UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_GASTest_Input_4, "GASTest.Input.4");
+UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_GASTest_Input_5, "GASTest.Input.5");
+UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_GASTest_State_Moving, "GASTest.State.Moving");
+UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_GASTest_State_Alternating, "GASTest.State.Alternating");
+
+static TConstArrayView<FGameplayTag> GetInputTags()
+{
+	static const FGameplayTag InputTags[] = { TAG_GASTest_Input_0, TAG_GASTest_Input_1, TAG_GASTest_Input_2, TAG_GASTest_Input_3, TAG_GASTest_Input_4, TAG_GASTest_Input_5 };
+	return InputTags;
+}
+
+FGameplayTag GASTest::GetInputTag(int32 Index)
+{
+	const TConstArrayView<FGameplayTag> InputTags = GetInputTags();
+	return InputTags.IsValidIndex(Index) ? InputTags[Index] : FGameplayTag();
+}
+
+UGASInputConfig* GASTest::CreateInputConfig(int32 NumActions)
+{
+	const GASInputEventType EventTypes[] = { GASInputEventType::GameplayAbility, GASInputEventType::GameplayEvent, GASInputEventType::GameplayDynamic };
+
+	const TConstArrayView<FGameplayTag> InputTags = GetInputTags();
+
+	UGASInputConfig* InputConfig = NewObject<UGASInputConfig>(GetTransientPackage());
+	for (int32 Index = 0; Index < FMath::Min(NumActions, InputTags.Num()); ++Index)
+	{
+		UInputAction* InputAction = NewObject<UInputAction>(InputConfig);
+		FEventActionPair& EventActions = InputConfig->AbilityInputActions.Add(InputAction).TaggedAction.Add(InputTags[Index]);
+		EventActions.SetEventType(ETriggerEvent::Started, EventTypes[Index % UE_ARRAY_COUNT(EventTypes)]);
+		EventActions.SetEventType(ETriggerEvent::Completed, EventTypes[Index % UE_ARRAY_COUNT(EventTypes)]);
+	}
+	return InputConfig;
+}
+
+UAbilityStateCheckObjects* GASTest::CreateStateChecks()
+{
+	UAbilityStateCheckObjects* StateChecks = NewObject<UAbilityStateCheckObjects>(GetTransientPackage());
+	UAbilityStateCheck_Velocity* MovingCheck = NewObject<UAbilityStateCheck_Velocity>(StateChecks);
+	UGASTestStateCheck_Alternating* AlternatingCheck = NewObject<UGASTestStateCheck_Alternating>(StateChecks);
+
+	// Granted tags and instancing are only ever authored in the editor
+	const FStructProperty* TagsToAddProperty = FindFProperty<FStructProperty>(UAbilityStateCheck_Base::StaticClass(), TEXT("TagsToAdd"));
+	*TagsToAddProperty->ContainerPtrToValuePtr<FGameplayTagContainer>(MovingCheck) = FGameplayTagContainer(TAG_GASTest_State_Moving);
+	*TagsToAddProperty->ContainerPtrToValuePtr<FGameplayTagContainer>(AlternatingCheck) = FGameplayTagContainer(TAG_GASTest_State_Alternating);
+	const FBoolProperty* StatelessProperty = FindFProperty<FBoolProperty>(UAbilityStateCheck_Base::StaticClass(), TEXT("bStateless"));
+	StatelessProperty->SetPropertyValue_InContainer(AlternatingCheck, true);
+
+	StateChecks->InlineStateChecks.Add(MovingCheck);
+	StateChecks->InlineStateChecks.Add(AlternatingCheck);
+	return StateChecks;
+}
+
+FGameplayAbilitySpecHandle GASTest::GrantInstantAbility(UAbilitySystemComponent& AbilitySystem, const FGameplayTag& InputTag)
+{
+	// Matched by its dynamic tags like by asset tags, and the ability class needn't know the test tags
+	FGameplayAbilitySpec AbilitySpec(UGASTestInstantAbility::StaticClass());
+	AbilitySpec.GetDynamicSpecSourceTags().AddTag(InputTag);
+	return AbilitySystem.GiveAbility(AbilitySpec);
+}
+
+void GASTest::ConfigurePawn(APawn& Pawn, UGASInputConfig* InputConfig, UAbilityStateCheckObjects* StateChecks)
+{
+	if (UAbilityInputHandler* InputHandler = Pawn.FindComponentByClass<UAbilityInputHandler>())
+	{
+		InputHandler->InputConfig = InputConfig;
+	}
+	if (UAbilityStateTagHandler* StateTagHandler = Pawn.FindComponentByClass<UAbilityStateTagHandler>())
+	{
+		StateTagHandler->AbilityStateTag = StateChecks;
+	}
+}
+
+AGASTestPawn* GASTest::SpawnPawn(UWorld* World, UGASInputConfig* InputConfig, UAbilityStateCheckObjects* StateChecks, const FVector& Location)
+{
+	AGASTestPawn* Pawn = World->SpawnActorDeferred<AGASTestPawn>(AGASTestPawn::StaticClass(), FTransform(Location));
+	if (Pawn)
+	{
+		ConfigurePawn(*Pawn, InputConfig, StateChecks);
+		Pawn->FinishSpawning(FTransform(Location));
+	}
+	return Pawn;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
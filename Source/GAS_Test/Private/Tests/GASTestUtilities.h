@@ -0,0 +1,84 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameplayAbilitySpecHandle.h"
+#include "GameplayTagContainer.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+class AGASTestPawn;
+class APawn;
+class UAbilitySystemComponent;
+class UAbilityStateCheckObjects;
+class UGASInputConfig;
+
+/**
+ * Standalone game world for the automation tests, torn down with this object. The repo has no map to load, so tests spawn
+ * their test pawns in it.
+ */
+class FGASTestWorld
+{
+public:
+	FGASTestWorld()
+	{
+		World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("GASTestWorld"));
+		FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+		WorldContext.SetCurrentWorld(World);
+
+		// Actors only begin play once the game mode started play
+		const FURL URL;
+		World->SetGameMode(URL);
+		World->InitializeActorsForPlay(URL);
+		World->BeginPlay();
+	}
+
+	~FGASTestWorld()
+	{
+		GEngine->DestroyWorldContext(World);
+		World->DestroyWorld(false);
+	}
+
+	UE_NONCOPYABLE(FGASTestWorld);
+
+	UWorld* GetWorld() const { return World; }
+
+	/** Engines only tick the worlds they own, tests tick theirs. */
+	void Tick(float DeltaSeconds)
+	{
+		World->Tick(LEVELTICK_All, DeltaSeconds);
+	}
+
+private:
+	UWorld* World = nullptr;
+};
+
+namespace GASTest
+{
+	/**
+	 * Transient input config binding NumActions input actions, each to its own native test tag, cycling through ability,
+	 * event and dynamic dispatch. Nothing references it, the caller keeps it alive.
+	 */
+	UGASInputConfig* CreateInputConfig(int32 NumActions = 3);
+
+	/** Native test tag bound to the action at Index by CreateInputConfig, GASTest.Input.<Index>. */
+	FGameplayTag GetInputTag(int32 Index);
+
+	/** Grants an instant ability activated by InputTag, so inputs sent with that tag reach a real activation. */
+	FGameplayAbilitySpecHandle GrantInstantAbility(UAbilitySystemComponent& AbilitySystem, const FGameplayTag& InputTag);
+
+	/**
+	 * Transient state check asset with two polled checks: one granting a native test tag while its owner moves, and a stateless
+	 * one granting another tag every other few frames so test pawns have state tags changing.
+	 */
+	UAbilityStateCheckObjects* CreateStateChecks();
+
+	/** Gives the handlers of a pawn that hasn't finished spawning their input config and state checks. */
+	void ConfigurePawn(APawn& Pawn, UGASInputConfig* InputConfig, UAbilityStateCheckObjects* StateChecks);
+
+	/** Spawns a test pawn configured with ConfigurePawn. */
+	AGASTestPawn* SpawnPawn(UWorld* World, UGASInputConfig* InputConfig, UAbilityStateCheckObjects* StateChecks, const FVector& Location = FVector::ZeroVector);
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -5,6 +5,8 @@
 #include "CoreMinimal.h"
 #include "AbilitySystemComponent.h"
 #include "Components/ActorComponent.h"
+#include "Engine/DataAsset.h"
+#include "GASInputConfig.h"
 #include "AbilityInputHandler.generated.h"
 
 
@@ -30,8 +32,21 @@ struct FAbilityAssignerSpec
 	
 };
 
+USTRUCT(BlueprintType)
+struct FSoftAbilityAssignment
+{
+	GENERATED_BODY()
+
+	/** Loaded with the "Abilities" bundle when the asset is loaded through the asset manager. */
+	UPROPERTY(EditDefaultsOnly, meta = (AssetBundles = "Abilities"))
+	TSoftClassPtr<UGameplayAbility> Ability;
+
+	UPROPERTY(EditDefaultsOnly)
+	FAbilityAssignerSpec Spec;
+};
+
 UCLASS()
-class GAS_TEST_API UDefaultAbilities : public UDataAsset
+class GAS_TEST_API UDefaultAbilities : public UPrimaryDataAsset
 {
 	GENERATED_BODY()
 
@@ -39,11 +54,42 @@ public:
 	UPROPERTY(EditDefaultsOnly, Category = "Input")
 	TMap<TSubclassOf<UGameplayAbility> ,FAbilityAssignerSpec> Abilities;
 
+	/** Abilities that are only loaded when granted, or preloaded with the "Abilities" bundle. */
+	UPROPERTY(EditDefaultsOnly, Category = "Input")
+	TArray<FSoftAbilityAssignment> SoftAbilities;
 	
 };
 
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnAbilityInputReady, UAbilityInputHandler*, Handler);
+
+
+/** Ability input that failed to activate, retried when one of the tags it failed on changes or an ability ends. */
+struct FBufferedAbilityInput
+{
+	FGameplayTag InputTag;
+
+	/** Tags the ASC reported when the input last failed: blocking, missing and cooldown tags along with the generic reasons. */
+	FGameplayTagContainer FailureTags;
+
+	/** World time after which the input is dropped. */
+	double ExpireTime = 0.0;
+
+	/** When the input first reached the handler, to measure the latency of buffered activations. */
+	uint64 PressCycles = 0;
 
-class UGASInputConfig;
+	GASInputEventType EventType = GASInputEventType::GameplayAbility;
+	ETriggerEvent TriggerEvent = ETriggerEvent::None;
+};
+
+class UInputAction;
+class UInputMappingContext;
+class UEnhancedInputLocalPlayerSubsystem;
+class UAbilityInputHandler;
+struct FStreamableHandle;
+class UEnhancedInputComponent;
+class UGameplayAbility_BaseTriggeredInputActionAbility;
+struct FInputActionInstance;
+struct FInputActionValue;
 
 UCLASS(ClassGroup=(Custom), meta=(BlueprintSpawnableComponent))
 class GAS_TEST_API UAbilityInputHandler : public UActorComponent
@@ -60,31 +106,267 @@ public:
 	UPROPERTY(EditDefaultsOnly, Category = "Input")
 	TObjectPtr<UGASInputConfig> InputConfig;
 	
-	void AbilityInput(FGameplayTag InInputTag);
+	void AbilityInput(FGameplayTag InInputTag, ETriggerEvent TriggerEvent = ETriggerEvent::None);
 	
-	void EventInput(FGameplayTag InInputTag);
+	void EventInput(FGameplayTag InInputTag, ETriggerEvent TriggerEvent = ETriggerEvent::None);
 	
-	void DynamicInput(FGameplayTag InInputTag);
+	void DynamicInput(FGameplayTag InInputTag, ETriggerEvent TriggerEvent = ETriggerEvent::None);
 	
 	UPROPERTY(EditDefaultsOnly, Category = "Abilities")
 	UDefaultAbilities* DefaultAbilities = nullptr;
-	
+
+	/** Used when InputConfig is not set, streamed in asynchronously on BeginPlay. */
+	UPROPERTY(EditDefaultsOnly, Category = "Input")
+	TSoftObjectPtr<UGASInputConfig> SoftInputConfig;
+
+	/** Used when DefaultAbilities is not set, streamed in asynchronously on BeginPlay along with its soft abilities. */
+	UPROPERTY(EditDefaultsOnly, Category = "Abilities")
+	TSoftObjectPtr<UDefaultAbilities> SoftDefaultAbilities;
+
+	/**
+	 * On a dedicated server, only grant the default abilities then deactivate: no input binding, mapping contexts, input buffering
+	 * or failure tracking, and SoftInputConfig is never loaded. Leave unset for server-controlled pawns driven through AbilityInput.
+	 */
+	UPROPERTY(EditDefaultsOnly, Category = "Networking")
+	bool bServerLean = false;
+
+	/** Bundles loaded with SoftDefaultAbilities when it is a primary asset known to the asset manager. */
+	UPROPERTY(EditDefaultsOnly, Category = "Abilities")
+	TArray<FName> DefaultAbilitiesBundles = { TEXT("Abilities") };
+
+	/** Broadcast once input is bound and the default abilities are granted, after the soft assets finished loading. */
+	UPROPERTY(BlueprintAssignable, Category = "Abilities")
+	FOnAbilityInputReady OnAbilityInputReady;
+
+	/** Whether input is bound and the default abilities granted, see OnAbilityInputReady. */
+	UFUNCTION(BlueprintPure, Category = "Abilities")
+	bool IsAbilityInputReady() const { return bAbilityInputReady; }
+
+	/**
+	 * Loads default ability assets with their bundles ahead of time, e.g. behind a loading screen, so handlers using them are ready on spawn.
+	 * The assets stay loaded until unloaded through the asset manager.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Abilities")
+	static void PreloadDefaultAbilities(const TArray<FPrimaryAssetId>& DefaultAbilitiesIds, const TArray<FName>& Bundles);
+
+	/**
+	 * Grants every ability the ASC doesn't already have, then activates the auto-activate ones by handle.
+	 * Activate-once abilities that fail to activate are cleared again, as GiveAbilityAndActivateOnce does. Server only.
+	 * @return Handles of the newly granted abilities, in the order of the map.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Abilities")
+	TArray<FGameplayAbilitySpecHandle> GrantAbilities(const TMap<TSubclassOf<UGameplayAbility>, FAbilityAssignerSpec>& Abilities);
+
+	/**
+	 * Makes the abilities granted from default ability assets match the asset: grants the missing ones, clears the ones it doesn't list
+	 * and updates the level and input ID of the others. Calling it again with the same asset changes nothing. Server only, the soft
+	 * abilities of the asset must be loaded.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Abilities")
+	void SyncAbilitiesToAsset(UDefaultAbilities* Asset);
+
+
+	/** How long, in seconds, an ability input that failed to activate is kept and retried. 0, the default, disables buffering. */
+	UPROPERTY(EditDefaultsOnly, Category = "Input", meta = (ClampMin = "0.0", Units = "s"))
+	float InputBufferWindow = 0.f;
+
+	/** Ignore repeated ability inputs for the same tag within a frame, e.g. several actions bound to one tag. */
+	UPROPERTY(EditDefaultsOnly, Category = "Input")
+	bool bCoalesceInputPerFrame = true;
+
+	/** Drops every buffered ability input. */
+	UFUNCTION(BlueprintCallable, Category = "Input")
+	void ClearInputBuffer();
+
+	/** Number of ability inputs activated through the tag index rather than by scanning every ability spec. */
+	UFUNCTION(BlueprintPure, Category = "Abilities")
+	int32 GetAvoidedAbilityScanCount() const { return AvoidedAbilityScans; }
+
+	/**
+	 * Routes the Triggered values of every input action bound to one of the ability's asset tags to the ability, until unregistered.
+	 * @return False if none of the ability's asset tags has a Triggered binding in the input config.
+	 */
+	bool RegisterTriggeredAbility(UGameplayAbility_BaseTriggeredInputActionAbility* Ability);
+
+	/** Stops routing Triggered values to the ability. */
+	void UnregisterTriggeredAbility(UGameplayAbility_BaseTriggeredInputActionAbility* Ability);
+
+	/** Routes a Triggered value of an input action to the registered triggered abilities, as the input component does. */
+	void TriggeredInput(const UInputAction* InputAction, const FInputActionValue& Value);
+
+	/**
+	 * Advances the chords and sequences of the input config on a press or release of an action, sending the tag of a
+	 * completed combo through AbilityInput, EventInput or DynamicInput. Bound to Started and Completed of every combo action.
+	 */
+	void ComboInput(const UInputAction* InputAction, bool bPressed);
+
 protected:
 	// Called when the game starts
 	virtual void BeginPlay() override;
+
+	// Called when the component is removed, unregisters the cached tag events
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	
 private:
 	void BindToInputConfig();
 
+	/** True if running server lean, see bServerLean. */
+	bool IsServerLean() const;
+
+	/** Binds input and grants the default abilities once every asset is loaded. */
+	void InitializeAbilityInput();
+
+	/** Streams in the soft input config and default abilities, then their soft abilities. */
+	void LoadSoftAssets();
+	void OnSoftAssetsLoaded();
+	void OnSoftAbilitiesLoaded();
+
+	/** Input component the config is bound to, and the handles of the bindings this handler made on it. */
+	TWeakObjectPtr<UEnhancedInputComponent> BoundInputComponent;
+	TArray<uint32> InputBindingHandles;
+
+	/** Removes the bindings this handler made, leaving the other bindings of the input component alone. */
+	void UnbindFromInputConfig();
+
+	/** Mapping contexts of the input config this handler added, the ones a subsystem already had are left to their owner. */
+	TArray<TObjectPtr<UInputMappingContext>> AddedMappingContexts;
+
+	/** Pending load of the soft assets. */
+	TSharedPtr<FStreamableHandle> SoftAssetsLoadHandle;
+
+	bool bAbilityInputReady = false;
+
 	UPROPERTY()
 	UAbilitySystemComponent* AbilitySystem = nullptr;
 
+	/** Ability specs matching each ability/dynamic input tag of the input config, as TryActivateAbilitiesByTag would find them. */
+	TMap<FGameplayTag, TArray<FGameplayAbilitySpecHandle>> AbilitySpecsByInputTag;
+
+	/** Activatable abilities when the index was built, compared against the ASC's if it doesn't report given and removed abilities. */
+	TArray<FGameplayAbilitySpecHandle> IndexedAbilityHandles;
+
+	/** Set when abilities are given, removed or their specs dirtied, forcing the index to be rebuilt. */
+	bool bAbilityIndexDirty = true;
+
+	/** True if the ASC reports given and removed abilities (see UGASAbilitySystemComponent), so the handles needn't be compared. */
+	bool bAbilityChangesReported = false;
+
+	FDelegateHandle AbilitiesChangedHandle;
+	FDelegateHandle AbilitySpecDirtiedHandle;
+
+	void OnAbilitySpecDirtied(const FGameplayAbilitySpec& Spec);
+
+	/** Returns true if TryActivateAbilitiesByTag would activate the spec for the input tag. */
+	static bool DoesSpecMatchInputTag(const FGameplayAbilitySpec& Spec, const FGameplayTag& InputTag);
+
+	/** Returns true if the ASC's activatable abilities differ from the ones the index was built from. */
+	bool HaveAbilityHandlesChanged(const TArray<FGameplayAbilitySpec>& AbilitySpecs) const;
+
+	/** See GetAvoidedAbilityScanCount. */
+	int32 AvoidedAbilityScans = 0;
+
+	/** Rebuilds AbilitySpecsByInputTag if abilities have been given, removed or had their dynamic tags changed since it was built. */
+	void UpdateAbilityIndex();
+
+	/** Whether the ASC has each dynamic input tag, kept up to date by tag events so DynamicInput doesn't query the ASC. */
+	TMap<FGameplayTag, bool> DynamicInputTagStates;
+
+	/** Tag event handles of DynamicInputTagStates, kept so they can be unregistered on EndPlay. */
+	TArray<TPair<FGameplayTag, FDelegateHandle>> DynamicInputTagHandles;
+
+	/** Reused by the AbilityInput fallback so it doesn't build a new container for every input. */
+	FGameplayTagContainer ScratchInputTags;
+
+	/** Reused by the AbilityInput fallback for the specs matching the input tag, it can't take an inline allocator. */
+	TArray<FGameplayAbilitySpec*> ScratchMatchingSpecs;
+
+	/** Caches the state of every dynamic input tag of the input config and starts tracking it. */
+	void CacheDynamicInputTagStates();
+
+	/** Stops tracking the dynamic input tags. */
+	void ClearDynamicInputTagStates();
+
+	void OnDynamicInputTagChanged(const FGameplayTag Tag, int32 NewCount);
+
+	/** AbilityInput and EventInput, with the binding type the input came from and when it reached the handler for the telemetry. */
+	void DispatchAbilityInput(const FGameplayTag& InInputTag, ETriggerEvent TriggerEvent, GASInputEventType EventType, uint64 StartCycles);
+	void DispatchEventInput(const FGameplayTag& InInputTag, ETriggerEvent TriggerEvent, GASInputEventType EventType, uint64 StartCycles);
+
+	/** Tries to activate the abilities of an input tag. */
+	bool TryActivateAbilityInput(const FGameplayTag& InInputTag);
+
+	/**
+	 * Tries to activate one ability in a server RPC batching scope, so its activation, target data and end reach the
+	 * server as one RPC when the ASC batches (see UGASAbilitySystemComponent).
+	 */
+	bool TryActivateAbilityBatched(const FGameplayAbilitySpecHandle& Handle);
+
+	/** Every failure tag the ASC reported during the last TryActivateAbilityInput, the first one being the main reason. */
+	FGameplayTagContainer LastActivationFailureTags;
+
+	FDelegateHandle AbilityFailedHandle;
+
+	void OnAbilityFailed(const UGameplayAbility* Ability, const FGameplayTagContainer& FailureTags);
+
+	/** Frame of the last ability input of each tag, see bCoalesceInputPerFrame. */
+	TMap<FGameplayTag, uint64> LastAbilityInputFrames;
+
+	/** Inputs waiting for whatever blocked them to clear, at most one per tag. */
+	TArray<FBufferedAbilityInput> BufferedAbilityInputs;
+
+	FDelegateHandle AnyTagChangedHandle;
+	FDelegateHandle AbilityEndedHandle;
+
+	/** Listens for the ASC events that may unblock a buffered input. */
+	void BindInputBufferEvents();
+	void UnbindInputBufferEvents();
+
+	/** A tag a buffered input failed on changed, retry the buffered inputs on the next tick. */
+	void OnAnyTagChanged(const FGameplayTag Tag, int32 NewCount);
+	void OnAbilityEnded(const FAbilityEndedData& EndedData);
+	void RequestBufferedInputRetry();
+
+	/** Retries the buffered inputs, dropping the ones that activate or expired. */
+	void RetryBufferedInputs();
+
+	/** Input actions with a Triggered binding for each tag of the input config, built once when binding to the config. */
+	TMap<FGameplayTag, TArray<TObjectPtr<const UInputAction>>> TriggeredActionsByTag;
+
+	/** Active triggered abilities listening to each input action, see RegisterTriggeredAbility. */
+	TMap<TObjectPtr<const UInputAction>, TArray<TWeakObjectPtr<UGameplayAbility_BaseTriggeredInputActionAbility>>> TriggeredAbilitiesByAction;
+
+	/** Builds TriggeredActionsByTag and binds each of its actions once, the bindings stay for as long as the input config is bound. */
+	void BindTriggeredActions(UEnhancedInputComponent* InputComp);
+
+	/** Single Triggered handler for every action of TriggeredActionsByTag, forwards the value to the registered abilities. */
+	void OnTriggeredInput(const FInputActionInstance& Instance);
+
+	/** Progress of this pawn through the combos of the input config. */
+	FGASInputComboState ComboState;
+
+	/** Binds the press and release of every action used by a combo of the input config. */
+	void BindComboActions(UEnhancedInputComponent* InputComp);
+
+	void OnComboInputPressed(const FInputActionInstance& Instance);
+	void OnComboInputReleased(const FInputActionInstance& Instance);
+
 	UFUNCTION(BlueprintCallable, Category = "Abilities")
-	void BulkGiveAbilities(TMap<TSubclassOf<UGameplayAbility> ,FAbilityAssignerSpec> Abilities);
+	void BulkGiveAbilities(const TMap<TSubclassOf<UGameplayAbility> ,FAbilityAssignerSpec>& Abilities);
+
+	/** Abilities granted from default ability assets, by class, kept to sync them when the loadout changes. */
+	TMap<TSubclassOf<UGameplayAbility>, FGameplayAbilitySpecHandle> GrantedDefaultAbilities;
+
+	/** Activate-once abilities that have run, so syncing to an asset still listing them doesn't grant and run them again. */
+	TSet<TSubclassOf<UGameplayAbility>> ActivatedOnceAbilities;
+
+	/** Hard and loaded soft abilities of a default abilities asset. */
+	static void GatherDefaultAbilities(const UDefaultAbilities* Asset, TMap<TSubclassOf<UGameplayAbility>, FAbilityAssignerSpec>& OutAbilities);
 
 	UFUNCTION(BlueprintCallable, Category = "Input")
 	void OnControllerChanged(APawn* Pawn, AController* OldController, AController* NewController);
 
+	static UEnhancedInputLocalPlayerSubsystem* GetInputSubsystem(AController* Controller);
+
 	void AddDefaultInputMappings(UGASInputConfig* InInputConfig, AController* Controller);
 	void RemoveDefaultInputMappings(UGASInputConfig* InInputConfig, AController* Controller);
 
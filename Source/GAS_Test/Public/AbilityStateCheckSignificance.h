@@ -0,0 +1,88 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "AbilityStateCheckSignificance.generated.h"
+
+/**
+ * How often a State Tag Handler evaluates its checks, from the significance of its owner.
+ */
+UENUM(BlueprintType)
+enum class EAbilityStateCheckLODTier : uint8
+{
+	/** Every check runs at its own rate. */
+	Full,
+
+	/** Polled checks run at most every ReducedInterval. */
+	Reduced,
+
+	/** Polled checks run at most every LowInterval. */
+	Low,
+
+	/** Only checks ignoring LOD run, the others resume when the owner becomes significant again. */
+	Suspended
+};
+
+/**
+ * Scores how significant the owner of a State Tag Handler is to the local viewers, and maps that score to a LOD tier.
+ * 
+ * The default score falls off with the distance to the closest viewer and is raised while the owner is on screen.
+ * Player controlled pawns always score 1. Override CalculateSignificance in a Blueprint or native child class for
+ * game-specific rules, e.g. combat targets or importance to the current objective.
+ */
+UCLASS(Blueprintable, EditInlineNew, DefaultToInstanced)
+class GAS_TEST_API UAbilityStateCheckSignificance : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	/**
+	 * Returns how significant the owner is, from 0 (irrelevant) to 1 (fully relevant).
+	 * @param ViewLocations - Camera locations of every player in the world.
+	 */
+	UFUNCTION(BlueprintNativeEvent, Category = "Significance")
+	float CalculateSignificance(const AActor* Owner, const TArray<FVector>& ViewLocations) const;
+
+	/** Tier matching a significance score. */
+	EAbilityStateCheckLODTier GetTier(float Significance) const;
+
+	/** Minimum time between two runs of a polled check in a tier, zero leaving the check's own interval. */
+	float GetTierInterval(EAbilityStateCheckLODTier Tier) const;
+
+	/** Time between two significance updates of a handler. */
+	float GetUpdateInterval() const { return UpdateInterval; }
+
+	/** False when significance based LOD is disabled with AbilityStateCheck.LOD.Enable. */
+	static bool IsLODEnabled();
+
+protected:
+	/** Distance at which the default score reaches 0. */
+	UPROPERTY(EditDefaultsOnly, Category = "Significance", meta = (ClampMin = "1.0", Units = "cm"))
+	float MaxDistance = 10000.f;
+
+	/** Lowest score of an owner rendered within the last frames, keeping visible actors up to date at any distance. */
+	UPROPERTY(EditDefaultsOnly, Category = "Significance", meta = (ClampMin = "0.0", ClampMax = "1.0"))
+	float RenderedSignificance = 0.5f;
+
+	/** Scores at or above this use the Full tier. */
+	UPROPERTY(EditDefaultsOnly, Category = "Tiers", meta = (ClampMin = "0.0", ClampMax = "1.0"))
+	float FullSignificance = 0.75f;
+
+	/** Scores at or above this use the Reduced tier. */
+	UPROPERTY(EditDefaultsOnly, Category = "Tiers", meta = (ClampMin = "0.0", ClampMax = "1.0"))
+	float ReducedSignificance = 0.4f;
+
+	/** Scores at or above this use the Low tier, anything lower is Suspended. */
+	UPROPERTY(EditDefaultsOnly, Category = "Tiers", meta = (ClampMin = "0.0", ClampMax = "1.0"))
+	float LowSignificance = 0.1f;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Tiers", meta = (ClampMin = "0.0", Units = "s"))
+	float ReducedInterval = 0.1f;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Tiers", meta = (ClampMin = "0.0", Units = "s"))
+	float LowInterval = 0.5f;
+
+	/** Time between two significance updates, each handler starts at a random offset so updates are spread over frames. */
+	UPROPERTY(EditDefaultsOnly, Category = "Significance", meta = (ClampMin = "0.02", Units = "s"))
+	float UpdateInterval = 0.5f;
+};
@@ -0,0 +1,153 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "AbilityStateCheckSubsystem.generated.h"
+
+class UAbilityStateTagHandler;
+class UAbilityStateCheck_Base;
+struct FAbilityStateCheckContext;
+struct FAbilityStateCheckTransitionScratch;
+
+/**
+ * Identifies a state check registered with the scheduler: the batch of its class and its slot in that batch.
+ */
+struct FAbilityStateCheckEntryId
+{
+	int32 BatchIndex = INDEX_NONE;
+	int32 EntryIndex = INDEX_NONE;
+};
+
+/**
+ * Scheduling state of one state check instance registered with the scheduler.
+ */
+struct FAbilityStateCheckScheduleEntry
+{
+	/** Handler that owns the state check instance. */
+	TWeakObjectPtr<UAbilityStateTagHandler> Handler;
+
+	/** The state check instance, kept alive by the handler. */
+	UAbilityStateCheck_Base* StateCheck = nullptr;
+
+	/** Evaluation context owned by the handler. */
+	const FAbilityStateCheckContext* Context = nullptr;
+
+	/** Scratch memory of the check and its exit condition for this handler, owned by the handler. */
+	FAbilityStateCheckTransitionScratch* Scratch = nullptr;
+
+	/** Index of the instance in the handler's state check array. */
+	int32 CheckIndex = INDEX_NONE;
+
+	/** Copied from the check, higher values run first. */
+	int32 Priority = 0;
+
+	/** Copied from the check, minimum time between two runs of a polled check. */
+	float Interval = 0.f;
+
+	/** Event-driven checks only become due when marked dirty. */
+	bool bEventDriven = false;
+
+	/** Copied from the check, the entry is parked while the handler's owner isn't locally controlled. */
+	bool bOwningClientOnly = false;
+
+	/** Set while the handler's LOD tier suspends the check, it is skipped but keeps its due time. */
+	bool bSuspended = false;
+
+	/** Minimum time between two runs imposed by the handler's LOD tier. */
+	float LODInterval = 0.f;
+
+	/** World time at which the entry becomes (or became) due. */
+	double DueTime = 0.0;
+};
+
+/**
+ * Every registered instance of one state check class, stored contiguously so they are evaluated together.
+ */
+struct FAbilityStateCheckBatch
+{
+	/** Class shared by every instance in the batch. */
+	const UClass* CheckClass = nullptr;
+
+	/** True if instances of this class are read-only and may be evaluated on worker threads. */
+	bool bThreadSafe = false;
+
+	/** Running average of the time one evaluation takes, used to fit the frame budget. Zero until the class is first evaluated. */
+	double AverageCostSeconds = 0.0;
+
+	/** Registered instances, sparse so that entry ids stay stable. */
+	TSparseArray<FAbilityStateCheckScheduleEntry> Entries;
+};
+
+/**
+ * World-level scheduler and batch evaluator for state checks.
+ * 
+ * State Tag Handlers using the world scheduler register their state checks here instead of ticking.
+ * Checks are stored in one batch per check class. Every frame the scheduler gathers the checks that are due,
+ * orders them by priority then by how long they have been waiting, and selects as many as fit in the per-frame
+ * budget (AbilityStateCheck.FrameBudgetUs) based on the measured cost of each class. Checks that have been waiting
+ * longer than AbilityStateCheck.MaxStarvationMs are always selected, whatever the budget.
+ * 
+ * The selected checks are then evaluated class by class. Thread-safe classes run through ParallelFor, the rest on
+ * the game thread, and the results are applied to each handler's tags on the game thread once every check has run.
+ * 
+ * The subsystem also owns the shared instances of stateless state check classes, see GetSharedStateCheck.
+ */
+UCLASS()
+class GAS_TEST_API UAbilityStateCheckSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/** Registers a state check instance, returning the id used to refer to it later. */
+	FAbilityStateCheckEntryId RegisterStateCheck(UAbilityStateTagHandler* Handler, int32 CheckIndex, UAbilityStateCheck_Base* StateCheck,
+		const FAbilityStateCheckContext& Context, FAbilityStateCheckTransitionScratch& Scratch);
+
+	/** Returns the instance of a stateless state check class shared by every handler of the world, creating it on first use. */
+	UAbilityStateCheck_Base* GetSharedStateCheck(TSubclassOf<UAbilityStateCheck_Base> StateCheckClass);
+
+	/** Removes a previously registered state check. */
+	void UnregisterStateCheck(const FAbilityStateCheckEntryId& EntryId);
+
+	/** Makes a registered state check due on the next scheduler tick. */
+	void MarkStateCheckDirty(const FAbilityStateCheckEntryId& EntryId);
+
+	/** Applies the LOD tier of the check's handler, see UAbilityStateCheckSignificance. */
+	void SetStateCheckLOD(const FAbilityStateCheckEntryId& EntryId, float LODInterval, bool bSuspended);
+
+	/** Camera locations of every player controller in the world, gathered at most once per frame. */
+	const TArray<FVector>& GetViewLocations();
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	/** Returns the registered entry for an id, or null if it has been unregistered. */
+	FAbilityStateCheckScheduleEntry* FindEntry(const FAbilityStateCheckEntryId& EntryId);
+
+	/** One batch per state check class. */
+	TArray<FAbilityStateCheckBatch> Batches;
+
+	/** Index of the batch of each registered class. */
+	TMap<const UClass*, int32> BatchIndexByClass;
+
+	/** Scratch array of due entries, kept to avoid reallocating every frame. */
+	TArray<FAbilityStateCheckEntryId> DueEntryIds;
+
+	/** Scratch array of due entries gated off by their handler, they are parked instead of evaluated. */
+	TArray<FAbilityStateCheckEntryId> GatedEntryIds;
+
+	/** Scratch array of evaluation results, parallel to the selected due entries. */
+	TArray<bool> Results;
+
+	/** See GetSharedStateCheck. */
+	UPROPERTY()
+	TMap<TSubclassOf<UAbilityStateCheck_Base>, TObjectPtr<UAbilityStateCheck_Base>> SharedStateChecks;
+
+	/** See GetViewLocations. */
+	TArray<FVector> ViewLocations;
+	uint64 ViewLocationsFrame = MAX_uint64;
+};
@@ -4,18 +4,116 @@
 #include "UObject/Object.h"
 #include "UObject/ObjectMacros.h"
 #include "GameplayTagContainer.h"
+#include "AttributeSet.h"
 #include "AbilityStateCheck_Base.generated.h"
 
+class ACharacter;
+class UAbilitySystemComponent;
+
+/**
+ * Everything a state check needs to know about the actor it is evaluated for.
+ * Built once by the State Tag Handler so native checks don't have to look components up on every run.
+ */
+struct FAbilityStateCheckContext
+{
+	/** The actor that owns the State Tag Handler. */
+	AActor* Owner = nullptr;
+
+	/** The owner's Ability System Component. */
+	UAbilitySystemComponent* AbilitySystem = nullptr;
+
+	/** The owner as a character, null if it isn't one. */
+	ACharacter* Character = nullptr;
+};
+
+/**
+ * Per-actor scratch memory of a state check. The State Tag Handler keeps one per check in a side array, so that a stateless
+ * check shared by every actor can still remember a few bytes between two runs for each of them, e.g. a timestamp.
+ */
+struct alignas(8) FAbilityStateCheckScratch
+{
+	uint8 Data[16] = {};
+
+	/** Views the scratch memory as a small trivially copyable type, zero initialized. */
+	template<typename T>
+	T& As()
+	{
+		static_assert(sizeof(T) <= sizeof(Data) && alignof(T) <= 8 && std::is_trivially_copyable_v<T>, "State check scratch is 16 bytes of plain data");
+		return *reinterpret_cast<T*>(Data);
+	}
+};
+
+/**
+ * Scratch memory of a check and of its exit condition for one actor. They are separate objects that may both keep
+ * something between runs, e.g. each its own timestamp, so each gets its own.
+ */
+struct FAbilityStateCheckTransitionScratch
+{
+	FAbilityStateCheckScratch Check;
+	FAbilityStateCheckScratch ExitCondition;
+};
+
+/**
+ * Controls when the State Tag Handler re-runs a state check.
+ */
+UENUM(BlueprintType)
+enum class EAbilityStateCheckUpdatePolicy : uint8
+{
+	/** Run the check every frame (legacy polling behaviour). */
+	EveryFrame UMETA(DisplayName = "Every Frame"),
+
+	/** Run the check only when one of its declared dependencies changes, or when it is marked dirty. */
+	EventDriven UMETA(DisplayName = "Event Driven")
+};
+
+/**
+ * Controls which machines evaluate a state check.
+ */
+UENUM(BlueprintType)
+enum class EAbilityStateCheckNetExecution : uint8
+{
+	/** Every machine with the owner runs the check: server, owning client and simulated proxies. */
+	Everywhere UMETA(DisplayName = "Everywhere"),
+
+	/** Only the authority runs the check. Replicated tags still reach the clients through replication. */
+	AuthorityOnly UMETA(DisplayName = "Authority Only"),
+
+	/** Only the machine controlling the owner runs the check, e.g. for UI or locally predicted abilities. Never on a dedicated server. */
+	OwningClientOnly UMETA(DisplayName = "Owning Client Only")
+};
+
 /**
  * A base object for performing checks on the state of the player.
  * An instance will be created by the State Tag Handler.
  * 
  * To use this, create a child class and override the 'Run' function
- * to implement a specific condition/state check.
+ * to implement a specific condition/state check. Native child classes
+ * should override 'Evaluate' instead, which is called directly and skips
+ * the Blueprint VM entirely.
  * 
  * - If `Run` returns true, the specified gameplay tags will be added
  *   to the ability component as loose tags.
  * - If `Run` returns false, the specified gameplay tags will be removed.
+ *
+ * By default a check is run every frame. Setting the update policy to
+ * 'Event Driven' makes the handler re-run it only when one of the declared
+ * dependencies (tags, attributes, movement mode, timer) changes, or when
+ * `MarkDirty` is called.
+ *
+ * Checks that keep no per-actor state can be flagged 'Stateless': a single
+ * instance of the class is then shared by every State Tag Handler of the
+ * world instead of one per actor. Shared instances are outered to the world
+ * rather than to a handler, and get the actor's scratch memory through
+ * 'EvaluateWithScratch' for what little they need to remember.
+ *
+ * Results at the edge of a condition can be stabilized per check: a rising
+ * or falling delay debounces the change, a minimum hold time keeps a result
+ * for a while after it changed, and a separate exit condition gives the
+ * check hysteresis (e.g. enter above 500 cm/s, exit below 400 cm/s).
+ *
+ * The net execution policy decides which machines instantiate the check at
+ * all, so a replicated check set to 'Authority Only' isn't also evaluated by
+ * every client only to be overwritten by replication.
  */
 UCLASS(Abstract, Blueprintable, BlueprintType)
 class GAS_TEST_API UAbilityStateCheck_Base : public UObject
@@ -30,9 +128,72 @@ public:
 	/** Overrides GetWorld to return the appropriate world context */
 	virtual UWorld* GetWorld() const override;
 
+	/** Caches whether a Blueprint child class implements 'Run' */
+	virtual void PostInitProperties() override;
+
+	/**
+	 * Evaluates the state check for the given context.
+	 * The default implementation calls the Blueprint 'Run' event; native checks override this instead.
+	 * 
+	 * @return true if the state check passes (tags will be added), false if it fails (tags will be removed).
+	 */
+	virtual bool Evaluate(const FAbilityStateCheckContext& Context);
+
+	/**
+	 * Evaluates the state check with the scratch memory the handler keeps for this check and actor. This is what handlers and the
+	 * scheduler call, the default implementation ignores the scratch memory and calls Evaluate.
+	 */
+	virtual bool EvaluateWithScratch(const FAbilityStateCheckContext& Context, FAbilityStateCheckScratch& Scratch);
+
+	/** Evaluates the check given its current result: while it passes, the exit condition decides when it stops passing. */
+	bool EvaluateTransition(const FAbilityStateCheckContext& Context, FAbilityStateCheckTransitionScratch& Scratch, bool bCurrentlyPassing);
+
 	/** Checks if the object has been properly instantiated */
 	bool IsInstantiated() const;
 
+	/** Requests that the owning State Tag Handler re-runs this check on its next update. */
+	UFUNCTION(BlueprintCallable, Category = "State Check")
+	void MarkDirty();
+
+	/** Returns true if this check only runs when its dependencies change. */
+	bool IsEventDriven() const { return UpdatePolicy == EAbilityStateCheckUpdatePolicy::EventDriven; }
+
+	/** Minimum time between two runs of an every frame check, zero meaning every frame. */
+	float GetEvaluationInterval() const { return IsEventDriven() ? 0.f : EvaluationInterval; }
+
+	/** Tags granted while the check passes. */
+	const FGameplayTagContainer& GetTagsToAdd() const { return TagsToAdd; }
+
+	/** Returns true if the granted tags are replicated. */
+	bool ShouldReplicate() const { return bShouldReplicate; }
+
+	/** Evaluation priority, higher values run first. */
+	int32 GetPriority() const { return Priority; }
+
+	/** Returns true if this check may be evaluated on a worker thread. Blueprint implementations never are. */
+	bool IsThreadSafe() const { return bThreadSafe && !bRunImplementedInScript && (!ExitCondition || ExitCondition->IsThreadSafe()); }
+
+	/** Returns true if one instance of this check may be shared by every actor. */
+	bool IsStateless() const { return bStateless && (!ExitCondition || ExitCondition->IsStateless()); }
+
+	/** Returns true if a delay or the hold time is set, the exit condition needs no help from the handler. */
+	bool HasStabilitySettings() const { return RisingDelay > 0.f || FallingDelay > 0.f || MinHoldTime > 0.f; }
+
+	/** Time the check must keep passing before its tags are added. */
+	float GetRisingDelay() const { return RisingDelay; }
+
+	/** Time the check must keep failing before its tags are removed. */
+	float GetFallingDelay() const { return FallingDelay; }
+
+	/** Minimum time a result is kept once it changed. */
+	float GetMinHoldTime() const { return MinHoldTime; }
+
+	/** Returns true if this check keeps running at its own rate whatever the significance of its owner. */
+	bool IgnoresLOD() const { return bIgnoreLOD; }
+
+	/** Which machines evaluate this check. */
+	EAbilityStateCheckNetExecution GetNetExecution() const { return NetExecution; }
+
 private:
 
 	/** Gameplay tags that will be added if the condition check succeeds */
@@ -43,8 +204,73 @@ private:
 	UPROPERTY(EditDefaultsOnly)
 	bool bShouldReplicate = true;
 
+	/** Which machines evaluate this check. Owning client checks are instantiated on every client and only pass while the owner is locally controlled */
+	UPROPERTY(EditDefaultsOnly, Category = "Networking")
+	EAbilityStateCheckNetExecution NetExecution = EAbilityStateCheckNetExecution::Everywhere;
+
+	/** Determines whether this check is polled every frame or only re-run when its dependencies change */
+	UPROPERTY(EditDefaultsOnly, Category = "Dependencies")
+	EAbilityStateCheckUpdatePolicy UpdatePolicy = EAbilityStateCheckUpdatePolicy::EveryFrame;
+
+	/** Re-run the check when any of these tags is added to or removed from the owner's ASC */
+	UPROPERTY(EditDefaultsOnly, Category = "Dependencies", Meta = (EditCondition = "UpdatePolicy == EAbilityStateCheckUpdatePolicy::EventDriven"))
+	FGameplayTagContainer DependencyTags;
+
+	/** Re-run the check when any of these attributes changes value on the owner's ASC */
+	UPROPERTY(EditDefaultsOnly, Category = "Dependencies", Meta = (EditCondition = "UpdatePolicy == EAbilityStateCheckUpdatePolicy::EventDriven"))
+	TArray<FGameplayAttribute> DependencyAttributes;
+
+	/** Re-run the check when the owning character changes movement mode */
+	UPROPERTY(EditDefaultsOnly, Category = "Dependencies", Meta = (EditCondition = "UpdatePolicy == EAbilityStateCheckUpdatePolicy::EventDriven"))
+	bool bDependsOnMovementMode = false;
+
+	/** If greater than zero, re-run the check at this interval (in seconds) */
+	UPROPERTY(EditDefaultsOnly, Category = "Dependencies", Meta = (EditCondition = "UpdatePolicy == EAbilityStateCheckUpdatePolicy::EventDriven", ClampMin = "0.0", Units = "s"))
+	float TimerInterval = 0.f;
+
+	/** Minimum time (in seconds) between two runs of an every frame check. Zero runs it every frame */
+	UPROPERTY(EditDefaultsOnly, Category = "Scheduling", Meta = (EditCondition = "UpdatePolicy == EAbilityStateCheckUpdatePolicy::EveryFrame", ClampMin = "0.0", Units = "s"))
+	float EvaluationInterval = 0.f;
+
+	/** Checks with a higher priority are evaluated first, and are the last to be deferred when the scheduler runs out of frame budget */
+	UPROPERTY(EditDefaultsOnly, Category = "Scheduling")
+	int32 Priority = 0;
+
+	/** The condition must keep passing this long (in seconds) before the tags are added */
+	UPROPERTY(EditDefaultsOnly, Category = "Stability", Meta = (ClampMin = "0.0", Units = "s"))
+	float RisingDelay = 0.f;
+
+	/** The condition must keep failing this long (in seconds) before the tags are removed */
+	UPROPERTY(EditDefaultsOnly, Category = "Stability", Meta = (ClampMin = "0.0", Units = "s"))
+	float FallingDelay = 0.f;
+
+	/** Once the result changed, it is kept at least this long (in seconds) whatever the condition does */
+	UPROPERTY(EditDefaultsOnly, Category = "Stability", Meta = (ClampMin = "0.0", Units = "s"))
+	float MinHoldTime = 0.f;
+
+	/** If set, evaluated instead of this check while it passes: the check stops passing once the exit condition passes. Dependencies are the ones of this check */
+	UPROPERTY(EditDefaultsOnly, Instanced, Category = "Stability")
+	TObjectPtr<UAbilityStateCheck_Base> ExitCondition;
+
+	/** One instance shared by every actor instead of one per actor. Only for checks (and 'Run' graphs) keeping nothing per actor in the object */
+	UPROPERTY(EditDefaultsOnly, Category = "Instancing")
+	bool bStateless = false;
+
+	/** Keeps running at full rate when the owner is far from every viewer, for checks gating gameplay-critical tags */
+	UPROPERTY(EditDefaultsOnly, Category = "Scheduling")
+	bool bIgnoreLOD = false;
+
+	/** True if 'Run' is implemented by a Blueprint class, false to avoid calling an empty event through ProcessEvent */
+	bool bRunImplementedInScript = false;
+
 protected:
 
+	/**
+	 * Set by native checks whose Evaluate only reads state (no writes to the owner, its components or this object).
+	 * Such checks are evaluated on worker threads by the world scheduler.
+	 */
+	bool bThreadSafe = false;
+
 	/**
 	 * Blueprint-implementable event for performing a state check.
 	 * 
@@ -0,0 +1,120 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "AbilityStateCheck_Base.h"
+#include "AttributeSet.h"
+#include "Engine/EngineTypes.h"
+#include "GameplayTagContainer.h"
+#include "AbilityStateCheck_Native.generated.h"
+
+/**
+ * Comparison used by the native threshold checks.
+ */
+UENUM(BlueprintType)
+enum class EAbilityStateComparison : uint8
+{
+	Less UMETA(DisplayName = "<"),
+	LessOrEqual UMETA(DisplayName = "<="),
+	Greater UMETA(DisplayName = ">"),
+	GreaterOrEqual UMETA(DisplayName = ">="),
+	Equal UMETA(DisplayName = "=="),
+	NotEqual UMETA(DisplayName = "!=")
+};
+
+namespace AbilityStateCheck
+{
+	/** Compares a value against a threshold using the given comparison. */
+	GAS_TEST_API bool Compare(float Value, EAbilityStateComparison Comparison, float Threshold);
+}
+
+/**
+ * Passes while the owning character is in one of the given movement modes.
+ */
+UCLASS(meta = (DisplayName = "Movement Mode State Check"))
+class GAS_TEST_API UAbilityStateCheck_MovementMode : public UAbilityStateCheck_Base
+{
+	GENERATED_BODY()
+
+public:
+	UAbilityStateCheck_MovementMode();
+
+	virtual bool Evaluate(const FAbilityStateCheckContext& Context) override;
+
+protected:
+	/** Movement modes in which the check passes */
+	UPROPERTY(EditDefaultsOnly, Category = "State Check")
+	TArray<TEnumAsByte<EMovementMode>> MovementModes;
+
+	/** Custom movement mode required when MOVE_Custom is one of the movement modes, ignored if negative */
+	UPROPERTY(EditDefaultsOnly, Category = "State Check")
+	int32 CustomMovementMode = -1;
+};
+
+/**
+ * Passes while an attribute of the owner's ASC compares favourably with a threshold.
+ */
+UCLASS(meta = (DisplayName = "Attribute Threshold State Check"))
+class GAS_TEST_API UAbilityStateCheck_AttributeThreshold : public UAbilityStateCheck_Base
+{
+	GENERATED_BODY()
+
+public:
+	UAbilityStateCheck_AttributeThreshold();
+
+	virtual bool Evaluate(const FAbilityStateCheckContext& Context) override;
+
+protected:
+	/** Attribute to read from the owner's ASC */
+	UPROPERTY(EditDefaultsOnly, Category = "State Check")
+	FGameplayAttribute Attribute;
+
+	UPROPERTY(EditDefaultsOnly, Category = "State Check")
+	EAbilityStateComparison Comparison = EAbilityStateComparison::Less;
+
+	UPROPERTY(EditDefaultsOnly, Category = "State Check")
+	float Threshold = 0.f;
+};
+
+/**
+ * Passes while the tags owned by the owner's ASC match a tag query.
+ */
+UCLASS(meta = (DisplayName = "Tag Query State Check"))
+class GAS_TEST_API UAbilityStateCheck_TagQuery : public UAbilityStateCheck_Base
+{
+	GENERATED_BODY()
+
+public:
+	UAbilityStateCheck_TagQuery();
+
+	virtual bool Evaluate(const FAbilityStateCheckContext& Context) override;
+
+protected:
+	UPROPERTY(EditDefaultsOnly, Category = "State Check")
+	FGameplayTagQuery Query;
+};
+
+/**
+ * Passes while the owner's speed compares favourably with a threshold.
+ */
+UCLASS(meta = (DisplayName = "Velocity State Check"))
+class GAS_TEST_API UAbilityStateCheck_Velocity : public UAbilityStateCheck_Base
+{
+	GENERATED_BODY()
+
+public:
+	UAbilityStateCheck_Velocity();
+
+	virtual bool Evaluate(const FAbilityStateCheckContext& Context) override;
+
+protected:
+	UPROPERTY(EditDefaultsOnly, Category = "State Check")
+	EAbilityStateComparison Comparison = EAbilityStateComparison::Greater;
+
+	/** Speed threshold, in cm/s */
+	UPROPERTY(EditDefaultsOnly, Category = "State Check", Meta = (ClampMin = "0.0", Units = "cm/s"))
+	float Threshold = 0.f;
+
+	/** If true, the vertical component of the velocity is ignored */
+	UPROPERTY(EditDefaultsOnly, Category = "State Check")
+	bool bHorizontalOnly = true;
+};
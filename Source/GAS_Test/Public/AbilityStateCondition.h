@@ -0,0 +1,266 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "AttributeSet.h"
+#include "Engine/EngineTypes.h"
+#include "GameplayTagContainer.h"
+#include "AbilityStateCheck_Native.h"
+#include "AbilityStateCondition.generated.h"
+
+struct FAbilityStateCheckContext;
+
+/**
+ * Operation of one node of a compiled state condition.
+ */
+enum class EAbilityStateConditionOp : uint8
+{
+	And,
+	Or,
+	Not,
+	TagQuery,
+	Attribute,
+	MovementMode,
+	Crouched,
+	Speed
+};
+
+/**
+ * One node of a compiled state condition. Nodes are stored depth first, children right after their parent, so a node
+ * and its whole subtree are contiguous and a subtree can be skipped in one step when short-circuiting.
+ */
+struct FAbilityStateConditionNode
+{
+	EAbilityStateConditionOp Op = EAbilityStateConditionOp::And;
+
+	/** Comparison of attribute and speed nodes. */
+	EAbilityStateComparison Comparison = EAbilityStateComparison::Less;
+
+	/** Number of direct children of and, or and not nodes. */
+	uint16 NumChildren = 0;
+
+	/** Number of nodes in the subtree, this one included. */
+	uint16 SubtreeSize = 1;
+
+	/** Custom movement mode of movement mode nodes, negative for any. */
+	int16 CustomMovementMode = INDEX_NONE;
+
+	/** Index into the tag queries or attributes of the program, bitmask of movement modes, or 1 for a horizontal speed. */
+	int32 Operand = 0;
+
+	/** Threshold of attribute and speed nodes. */
+	float Threshold = 0.f;
+};
+
+/**
+ * A state condition flattened into an array of nodes, evaluated natively and read-only so it can run on any thread.
+ */
+struct GAS_TEST_API FAbilityStateConditionProgram
+{
+	TArray<FAbilityStateConditionNode> Nodes;
+
+	/** Operands of the tag query nodes. */
+	TArray<FGameplayTagQuery> TagQueries;
+
+	/** Operands of the attribute nodes. */
+	TArray<FGameplayAttribute> Attributes;
+
+	/** Appends a node, returning its index so compound nodes can fix up their size once their children are compiled. */
+	int32 AddNode(EAbilityStateConditionOp Op);
+
+	/** Sets the subtree size of a compound node once every child has been appended. */
+	void FinishNode(int32 NodeIndex, int32 NumChildren);
+
+	/** Runs the program, an empty program fails. */
+	bool Evaluate(const FAbilityStateCheckContext& Context) const;
+
+	void Reset();
+
+private:
+	bool EvaluateNode(const FAbilityStateCheckContext& Context, int32 NodeIndex) const;
+};
+
+/**
+ * A node of a state condition expression, authored inline in the Expression State Check of a state check asset.
+ * Conditions are only used to build the flat program the check runs, they are never evaluated themselves.
+ */
+UCLASS(Abstract, EditInlineNew, DefaultToInstanced, CollapseCategories)
+class GAS_TEST_API UAbilityStateCondition : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	/** Appends this condition and its children to the program. */
+	virtual void Compile(FAbilityStateConditionProgram& Program) const PURE_VIRTUAL(UAbilityStateCondition::Compile, );
+};
+
+/**
+ * Passes if every child condition passes.
+ */
+UCLASS(meta = (DisplayName = "All Of"))
+class GAS_TEST_API UAbilityStateCondition_And : public UAbilityStateCondition
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Compile(FAbilityStateConditionProgram& Program) const override;
+
+	UPROPERTY(EditDefaultsOnly, Instanced, Category = "Condition")
+	TArray<TObjectPtr<UAbilityStateCondition>> Conditions;
+};
+
+/**
+ * Passes if any child condition passes.
+ */
+UCLASS(meta = (DisplayName = "Any Of"))
+class GAS_TEST_API UAbilityStateCondition_Or : public UAbilityStateCondition
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Compile(FAbilityStateConditionProgram& Program) const override;
+
+	UPROPERTY(EditDefaultsOnly, Instanced, Category = "Condition")
+	TArray<TObjectPtr<UAbilityStateCondition>> Conditions;
+};
+
+/**
+ * Passes if the child condition fails.
+ */
+UCLASS(meta = (DisplayName = "Not"))
+class GAS_TEST_API UAbilityStateCondition_Not : public UAbilityStateCondition
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Compile(FAbilityStateConditionProgram& Program) const override;
+
+	UPROPERTY(EditDefaultsOnly, Instanced, Category = "Condition")
+	TObjectPtr<UAbilityStateCondition> Condition;
+};
+
+/**
+ * Passes while the tags owned by the owner's ASC match a tag query.
+ */
+UCLASS(meta = (DisplayName = "Tag Query"))
+class GAS_TEST_API UAbilityStateCondition_TagQuery : public UAbilityStateCondition
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Compile(FAbilityStateConditionProgram& Program) const override;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Condition")
+	FGameplayTagQuery Query;
+};
+
+/**
+ * Passes while an attribute of the owner's ASC compares favourably with a threshold.
+ */
+UCLASS(meta = (DisplayName = "Attribute"))
+class GAS_TEST_API UAbilityStateCondition_Attribute : public UAbilityStateCondition
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Compile(FAbilityStateConditionProgram& Program) const override;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Condition")
+	FGameplayAttribute Attribute;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Condition")
+	EAbilityStateComparison Comparison = EAbilityStateComparison::Less;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Condition")
+	float Threshold = 0.f;
+};
+
+/**
+ * Passes while the owning character is in one of the given movement modes.
+ */
+UCLASS(meta = (DisplayName = "Movement Mode"))
+class GAS_TEST_API UAbilityStateCondition_MovementMode : public UAbilityStateCondition
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Compile(FAbilityStateConditionProgram& Program) const override;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Condition")
+	TArray<TEnumAsByte<EMovementMode>> MovementModes;
+
+	/** Custom movement mode required when MOVE_Custom is one of the movement modes, ignored if negative */
+	UPROPERTY(EditDefaultsOnly, Category = "Condition")
+	int32 CustomMovementMode = -1;
+};
+
+/**
+ * Passes while the owning character is crouched.
+ */
+UCLASS(meta = (DisplayName = "Crouched"))
+class GAS_TEST_API UAbilityStateCondition_Crouched : public UAbilityStateCondition
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Compile(FAbilityStateConditionProgram& Program) const override;
+};
+
+/**
+ * Passes while the owner's speed compares favourably with a threshold.
+ */
+UCLASS(meta = (DisplayName = "Speed"))
+class GAS_TEST_API UAbilityStateCondition_Speed : public UAbilityStateCondition
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Compile(FAbilityStateConditionProgram& Program) const override;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Condition")
+	EAbilityStateComparison Comparison = EAbilityStateComparison::Greater;
+
+	/** Speed threshold, in cm/s */
+	UPROPERTY(EditDefaultsOnly, Category = "Condition", Meta = (ClampMin = "0.0", Units = "cm/s"))
+	float Threshold = 0.f;
+
+	/** If true, the vertical component of the velocity is ignored */
+	UPROPERTY(EditDefaultsOnly, Category = "Condition")
+	bool bHorizontalOnly = true;
+};
+
+/**
+ * A data-only state check whose condition is an expression of tag queries, attribute comparisons and movement
+ * conditions combined with and, or and not, authored inline in a state check asset's InlineStateChecks.
+ * 
+ * The expression is compiled into a flat program on load and evaluated natively, without the Blueprint VM.
+ * Expression checks are stateless and read-only, so one instance serves every actor and the world scheduler
+ * evaluates them on worker threads.
+ */
+UCLASS(EditInlineNew, meta = (DisplayName = "Expression State Check"))
+class GAS_TEST_API UAbilityStateCheck_Expression : public UAbilityStateCheck_Base
+{
+	GENERATED_BODY()
+
+public:
+	UAbilityStateCheck_Expression();
+
+	virtual void PostInitProperties() override;
+	virtual void PostLoad() override;
+
+#if WITH_EDITOR
+	virtual void PostEditChangeChainProperty(FPropertyChangedChainEvent& PropertyChangedEvent) override;
+#endif
+
+	virtual bool Evaluate(const FAbilityStateCheckContext& Context) override;
+
+	/** Rebuilds the program from the condition, must not be called while the check may be evaluated. */
+	void CompileCondition();
+
+	/** Root of the expression */
+	UPROPERTY(EditDefaultsOnly, Instanced, Category = "State Check")
+	TObjectPtr<UAbilityStateCondition> Condition;
+
+private:
+	FAbilityStateConditionProgram Program;
+};
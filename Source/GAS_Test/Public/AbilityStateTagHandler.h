@@ -4,11 +4,61 @@
 #include "AbilityStateCheck_Base.h"
 #include "Components/ActorComponent.h"
 #include "AbilitySystemComponent.h"
+#include "AbilityStateCheckSubsystem.h"
+#include "AbilityStateCheckSignificance.h"
 #include "AbilityStateTagHandler.generated.h"
 
+class ACharacter;
+class AController;
+class APawn;
+struct FStreamableHandle;
+
+/**
+ * Replicated state tags of a State Tag Handler, one bit per entry of the state check asset's replicated tag table.
+ * Only the bits are sent, the tags themselves are resolved on each side from the shared asset.
+ */
+USTRUCT()
+struct GAS_TEST_API FAbilityStateTagBits
+{
+	GENERATED_BODY()
+
+	/** One bit per tag of UAbilityStateCheckObjects::GetReplicatedTagTable. */
+	TBitArray<> Bits;
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+
+	bool operator==(const FAbilityStateTagBits& Other) const { return Bits == Other.Bits; }
+};
+
+template<>
+struct TStructOpsTypeTraits<FAbilityStateTagBits> : public TStructOpsTypeTraitsBase2<FAbilityStateTagBits>
+{
+	enum
+	{
+		WithNetSerializer = true,
+		WithIdenticalViaEquality = true
+	};
+};
+
+/**
+ * Debounce state of one state check of a State Tag Handler, see the stability settings of UAbilityStateCheck_Base.
+ */
+struct FAbilityStateCheckStability
+{
+	/** World time since which the raw result has differed from the applied one, negative if it doesn't. */
+	double PendingSince = -1.0;
+
+	/** World time of the last change of the applied result. */
+	double LastChangeTime = -UE_BIG_NUMBER;
+
+	/** Re-runs the check once a pending change is allowed, so event-driven checks don't miss it. */
+	FTimerHandle RetryTimerHandle;
+};
+
 /**
  * Data asset that holds a set of state check classes.
  * This allows designers to specify a group of state check objects to be used in gameplay.
+ * Data-only checks, such as expression checks, are authored in the asset itself.
  */
 UCLASS()
 class GAS_TEST_API UAbilityStateCheckObjects : public UDataAsset
@@ -19,18 +69,52 @@ public:
 	/** A set of state check classes that will be used to evaluate ability-related conditions. */
 	UPROPERTY(EditDefaultsOnly)
 	TSet<TSubclassOf<UAbilityStateCheck_Base>> StateChecks;
+
+	/** State checks configured in the asset, e.g. Expression State Checks. Stateless ones are used as they are, the others are copied for each actor. */
+	UPROPERTY(EditDefaultsOnly, Instanced)
+	TArray<TObjectPtr<UAbilityStateCheck_Base>> InlineStateChecks;
+
+	/**
+	 * Every tag granted by a replicated state check, sorted by name so that the index of a tag
+	 * is the same on every machine. Built on first use.
+	 */
+	const TArray<FGameplayTag>& GetReplicatedTagTable() const;
+
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+	virtual void PostEditChangeChainProperty(FPropertyChangedChainEvent& PropertyChangedEvent) override;
+#endif
+
+private:
+	/** Cache for GetReplicatedTagTable. */
+	mutable TArray<FGameplayTag> ReplicatedTagTable;
+
+	mutable bool bReplicatedTagTableBuilt = false;
 };
 
 /**
  * An actor component responsible for managing ability state tags.
  * 
  * This component checks conditions through AbilityStateCheck instances and applies/removes gameplay tags accordingly.
+ * Tags are reference counted across checks: a tag stays applied while at least one passing check grants it, and the
+ * changes from an update are applied with a single batched add and remove.
+ * Event-driven checks are only re-run when one of their dependencies changes; if every check is event-driven,
+ * the component only ticks on frames where at least one check has been marked dirty.
+ * 
+ * With compact tag replication, replicated checks only run on the authority and their tags are sent to clients as a
+ * single bitfield, indexed by the state check asset's replicated tag table, instead of as replicated loose tags.
+ * 
+ * When using the world scheduler, the component never ticks: its checks are evaluated by the
+ * UAbilityStateCheckSubsystem, within a per-frame budget shared by every handler in the world.
  */
 UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
 class GAS_TEST_API UAbilityStateTagHandler : public UActorComponent
 {
 	GENERATED_BODY()
 
+	// Granting the scheduler access to the results of individual checks
+	friend class UAbilityStateCheckSubsystem;
+
 public:
 	// Sets default values for this component's properties
 	UAbilityStateTagHandler();
@@ -39,10 +123,45 @@ public:
 	UPROPERTY(EditDefaultsOnly)
 	UAbilityStateCheckObjects* AbilityStateTag = nullptr;
 
+	/** Used when AbilityStateTag is not set, streamed in asynchronously on BeginPlay so spawning the owner doesn't load the state checks. */
+	UPROPERTY(EditDefaultsOnly)
+	TSoftObjectPtr<UAbilityStateCheckObjects> SoftAbilityStateTag;
+
+	/** If true, checks are evaluated by the world's state check scheduler within its frame budget instead of by this component's tick. */
+	UPROPERTY(EditDefaultsOnly)
+	bool bUseWorldScheduler = false;
+
+	/** If true, tags from replicated checks are replicated by this component as one bitfield instead of as replicated loose tags on the ASC. */
+	UPROPERTY(EditDefaultsOnly)
+	bool bCompactTagReplication = false;
+
+	/** If set, checks run less often (or not at all) while the owner is insignificant to every viewer. Checks flagged IgnoreLOD are not affected. */
+	UPROPERTY(EditDefaultsOnly, Instanced)
+	TObjectPtr<UAbilityStateCheckSignificance> Significance;
+
+	/** Current level of detail of the checks, always Full without a significance policy. */
+	UFUNCTION(BlueprintPure, Category = "State Check")
+	EAbilityStateCheckLODTier GetLODTier() const { return LODTier; }
+
+	/** Flags a state check instance to be re-run on the next update. */
+	void MarkStateCheckDirty(const UAbilityStateCheck_Base* StateCheck);
+
+	/** Flags every state check to be re-run on the next update. */
+	UFUNCTION(BlueprintCallable, Category = "State Check")
+	void MarkAllStateChecksDirty();
+
 protected:
+	/** Replicates the component only if it replicates the state tag bits. */
+	virtual void OnRegister() override;
+
 	/** Called when the game starts or when the component is first initialized. */
 	virtual void BeginPlay() override;
 
+	/** Unbinds every dependency delegate and timer registered by the event-driven checks. */
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
 public:
 	/** Called every frame to update the component. */
 	virtual void TickComponent(float DeltaTime, ELevelTick TickType,
@@ -53,11 +172,165 @@ private:
 	UPROPERTY()
 	UAbilitySystemComponent* OwnersASC = nullptr;
 
+	/** Owner, ASC and character passed to every state check evaluation. */
+	FAbilityStateCheckContext StateCheckContext;
+
+	/** Pending load of SoftAbilityStateTag. */
+	TSharedPtr<FStreamableHandle> StateCheckLoadHandle;
+
+	void OnStateCheckObjectsLoaded();
+
+	/** Instantiates the checks of AbilityStateTag and sets up their scheduling and dependencies. */
+	void InitializeStateChecks();
+
 	/** Array of instantiated state check objects that will be evaluated. */
 	UPROPERTY()
 	TArray<UAbilityStateCheck_Base*> AbilityStateCheckInstances;
 
-	/** Determines which gameplay tags are missing from the provided list and need to be added. */
-	FGameplayTagContainer GetMissingTags(TArray<FGameplayTag> Tags);
+	/** Scratch memory of each instance and its exit condition, see FAbilityStateCheckScratch. Sized once so the scheduler can keep pointers into it. */
+	TArray<FAbilityStateCheckTransitionScratch> StateCheckScratch;
+
+	/** Debounce state of each instance, only used by checks with stability settings. */
+	TArray<FAbilityStateCheckStability> StateCheckStability;
+
+	/** Flags, per instance, whether an event-driven check needs to be re-run. */
+	TBitArray<> DirtyStateChecks;
+
+	/** Number of instances that are polled every frame. When zero, the component only ticks while checks are dirty. */
+	int32 NumEveryFrameStateChecks = 0;
+
+	/** Last result of each instance, so unchanged results cost nothing. */
+	TBitArray<> StateCheckResults;
+
+	/** Number of passing non-replicated checks granting each tag. */
+	TMap<FGameplayTag, int32> LocalStateTagCounts;
+
+	/** Number of passing replicated checks granting each tag. */
+	TMap<FGameplayTag, int32> ReplicatedStateTagCounts;
+
+	/** Non-replicated tags currently applied to the ASC by this component. */
+	FGameplayTagContainer AppliedLocalStateTags;
+
+	/** Replicated tags currently applied to the ASC by this component. */
+	FGameplayTagContainer AppliedReplicatedStateTags;
+
+	/** True when a check result has changed since the last flush. */
+	bool bStateTagsDirty = false;
+
+	/** True if bCompactTagReplication is set and allowed by AbilityStateCheck.CompactTagReplication, decided when registered. */
+	bool bReplicateStateTagBits = false;
+
+	/**
+	 * Replicated state tags, only used with compact tag replication. Push-based when the engine is built with push model
+	 * replication, so a stable handler costs nothing, otherwise compared like any other replicated property.
+	 */
+	UPROPERTY(ReplicatedUsing = OnRep_ReplicatedStateTagBits)
+	FAbilityStateTagBits ReplicatedStateTagBits;
+
+	/** World time at which each polled check is next due, for checks with an evaluation interval. */
+	TArray<double> NextEvaluationTimes;
+
+	/** Scheduler the checks are registered with, if using the world scheduler. */
+	UPROPERTY()
+	UAbilityStateCheckSubsystem* Scheduler = nullptr;
+
+	/** Scheduler entry id of each instance, if using the world scheduler. */
+	TArray<FAbilityStateCheckEntryId> ScheduledEntryIds;
+
+	/** Indices of the checks that depend on the owning character's movement mode. */
+	TArray<int32> MovementModeDependentChecks;
+
+	/** Delegate handles for the tag dependencies, kept so they can be unregistered on EndPlay. */
+	TArray<TPair<FGameplayTag, FDelegateHandle>> TagDependencyHandles;
+
+	/** Delegate handles for the attribute dependencies, kept so they can be unregistered on EndPlay. */
+	TArray<TPair<FGameplayAttribute, FDelegateHandle>> AttributeDependencyHandles;
+
+	/** Timers driving checks with a timer interval. */
+	TArray<FTimerHandle> DependencyTimerHandles;
+
+	/** Current LOD tier and the minimum time between two runs it imposes on the checks affected by LOD. */
+	EAbilityStateCheckLODTier LODTier = EAbilityStateCheckLODTier::Full;
+	float LODInterval = 0.f;
+
+	/** Number of checks flagged IgnoreLOD, they keep the tick alive while the others are suspended. */
+	int32 NumLODExemptChecks = 0;
+
+	/** Timer re-evaluating the significance of the owner. */
+	FTimerHandle SignificanceTimerHandle;
+
+	/** Scores the owner against the current view locations and applies the resulting tier. */
+	void UpdateSignificance();
+
+	/** Applies a LOD tier to every check affected by LOD. */
+	void SetLODTier(EAbilityStateCheckLODTier NewTier);
+
+	/** Returns true if this machine should evaluate checks of the given class, according to its net execution policy and the tag replication mode. */
+	bool ShouldRunStateCheckLocally(const UAbilityStateCheck_Base* StateCheckCDO) const;
+
+	/**
+	 * True while this machine controls the owner. Owning client checks are instantiated on every client, as the owner is
+	 * usually possessed after BeginPlay, and only pass while this is set.
+	 */
+	bool bOwnerLocallyControlled = false;
+
+	/** Returns true if the owner is controlled by this machine, a dedicated server never controls it. */
+	bool IsOwnerLocallyControlled() const;
+
+	/** Re-runs the owning client checks when the owning pawn is possessed or unpossessed. */
+	UFUNCTION()
+	void OnOwnerControllerChanged(APawn* Pawn, AController* OldController, AController* NewController);
+
+	/** Adds the instance of a state check this handler evaluates, shared if the check is stateless, otherwise created from the template. */
+	void AddStateCheckInstance(UAbilityStateCheck_Base* Template, UAbilityStateCheck_Base* SharedInstance);
+
+	/** Runs a single state check and adds/removes its tags based on the result. */
+	void EvaluateStateCheck(int32 CheckIndex);
+
+	/** Records the result of the state check at the given index, updating the tag reference counts if it changed. */
+	void ApplyStateCheckResult(int32 CheckIndex, bool bPassed);
+
+	/**
+	 * Applies the delays and hold time of a check to a new raw result, returning the result to apply. A change that isn't allowed yet
+	 * schedules a re-run of the check for when it will be.
+	 */
+	bool StabilizeStateCheckResult(int32 CheckIndex, bool bPassed);
+
+	/** Registers the dependency delegates of an event-driven check. */
+	void BindStateCheckDependencies(int32 CheckIndex);
+
+	/** Removes every dependency delegate and timer. */
+	void UnbindStateCheckDependencies();
+
+	/** Flags the check at the given index dirty and makes sure the component ticks on the next frame. */
+	void MarkStateCheckDirtyAt(int32 CheckIndex);
+
+	void OnDependencyTagChanged(const FGameplayTag Tag, int32 NewCount, int32 CheckIndex);
+
+	void OnDependencyAttributeChanged(const FOnAttributeChangeData& ChangeData, int32 CheckIndex);
+
+	UFUNCTION()
+	void OnOwnerMovementModeChanged(ACharacter* Character, EMovementMode PrevMovementMode, uint8 PreviousCustomMode);
+
+	/** Applies the tag changes accumulated since the last flush, with one batched add and one batched remove. */
+	void FlushStateTags();
+
+	/** Applies one set of reference counted tags. */
+	void FlushStateTagSet(const TMap<FGameplayTag, int32>& TagCounts, FGameplayTagContainer& AppliedTags, bool bShouldReplicate);
+
+	/** Diffs the wanted tags against the tags applied previously, adding and removing the difference in one batch each way. */
+	void ApplyStateTagDiff(const FGameplayTagContainer& WantedTags, FGameplayTagContainer& AppliedTags, bool bShouldReplicate);
+
+	/** Returns true if replicated checks run on the authority only and their tags go through ReplicatedStateTagBits. */
+	bool UsesCompactTagReplication() const;
+
+	/** Rebuilds ReplicatedStateTagBits from the applied replicated tags, marking it dirty for replication if it changed. */
+	void UpdateReplicatedStateTagBits();
+
+	/** Applies the tags from ReplicatedStateTagBits on a client. */
+	void ApplyReplicatedStateTagBits();
+
+	UFUNCTION()
+	void OnRep_ReplicatedStateTagBits();
 };
 
@@ -0,0 +1,34 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "AbilitySystemComponent.h"
+#include "GASAbilitySystemComponent.generated.h"
+
+/**
+ * Ability System Component opting into GAS server ability RPC batching.
+ * 
+ * UAbilityInputHandler opens a batch around every activation it requests. With batching, a locally predicted ability
+ * that activates, sends target data and ends within that scope reaches the server as one ServerAbilityRPCBatch
+ * instead of a ServerTryActivateAbility, a ServerSetReplicatedTargetData and a ServerEndAbility. Other ASC classes
+ * never batch, so the handler behaves as before with them.
+ * 
+ * It also reports abilities being given and removed, so the handler only rebuilds its ability index when they change.
+ */
+UCLASS(ClassGroup=(Custom), meta=(BlueprintSpawnableComponent))
+class GAS_TEST_API UGASAbilitySystemComponent : public UAbilitySystemComponent
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldDoServerAbilityRPCBatch() const override;
+
+	virtual void OnGiveAbility(FGameplayAbilitySpec& AbilitySpec) override;
+	virtual void OnRemoveAbility(FGameplayAbilitySpec& AbilitySpec) override;
+
+	/** Broadcast when an ability is given or removed, on the server and on clients as the specs replicate. */
+	FSimpleMulticastDelegate OnAbilitiesChanged;
+
+	/** If true, abilities activated through a batching scope send their server RPCs as one batch. Only used on clients. */
+	UPROPERTY(EditDefaultsOnly, Category = "Networking")
+	bool bBatchServerAbilityRPCs = true;
+};
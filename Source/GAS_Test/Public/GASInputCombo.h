@@ -0,0 +1,114 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayTagContainer.h"
+
+class UInputAction;
+struct FGASInputCombo;
+enum class GASInputEventType : uint8;
+
+/**
+ * What a completed combo dispatches, and what the matcher needs to validate its timing.
+ */
+struct FGASCompiledInputCombo
+{
+	FGameplayTag InputTag;
+	GASInputEventType EventType = static_cast<GASInputEventType>(0);
+	uint8 NumSteps = 0;
+	float MaxStepInterval = 0.f;
+};
+
+/**
+ * Per pawn progress through the combos of a config, advanced by FGASInputComboMatcher.
+ */
+struct FGASInputComboState
+{
+	/** Maximum length of a sequence, the matcher keeps the press times of that many steps. */
+	static constexpr int32 MaxSteps = 8;
+
+	/** Current state of the sequence automaton, 0 being no progress. */
+	int32 SequenceState = 0;
+
+	/** Actions currently held, one bit per matcher symbol. */
+	uint64 HeldSymbols = 0;
+
+	/** Press times of the last steps, indexed by step count modulo MaxSteps. */
+	double StepTimes[MaxSteps] = {};
+
+	/** Steps pressed since the automaton was last reset. */
+	uint32 NumSteps = 0;
+
+	void Reset() { *this = FGASInputComboState(); }
+};
+
+/**
+ * The combos of an input config compiled into one matcher, shared by every pawn using the config.
+ * 
+ * Sequences form an Aho-Corasick automaton over the actions used by combos: a dense transition table gives the next
+ * state for any press in one lookup, overlapping sequences share states and a failed prefix falls back to the longest
+ * sequence it still ends. Chords are bitmasks of held actions, grouped by the action completing them. A press thus costs
+ * one table lookup, plus the chords of that action and, when a sequence ends, checking its step times.
+ */
+struct GAS_TEST_API FGASInputComboMatcher
+{
+	/** Compiles the combos, skipping and reporting invalid ones. Owner is only used to name the config in logs. */
+	void Compile(const TArray<FGASInputCombo>& Combos, const UObject* Owner);
+
+	void Reset();
+
+	bool IsEmpty() const { return CompiledCombos.IsEmpty(); }
+
+	/** Returns the symbol of an action used by a combo, or INDEX_NONE. */
+	int32 FindSymbol(const UInputAction* InputAction) const;
+
+	/** Input actions used by combos, indexed by symbol. */
+	TConstArrayView<const UInputAction*> GetActions() const { return Actions; }
+
+	/** Advances the state on a press at Time, in seconds. Returns the combo it completes, if any, after which the state starts over. */
+	const FGASCompiledInputCombo* OnPressed(FGASInputComboState& State, int32 Symbol, double Time) const;
+
+	/** Releases a held action, breaking the chords using it. */
+	void OnReleased(FGASInputComboState& State, int32 Symbol) const;
+
+	/** Number of states of the sequence automaton. */
+	int32 GetNumStates() const { return StateOutputs.Num(); }
+
+	/** Bytes used by the compiled tables. */
+	SIZE_T GetAllocatedSize() const;
+
+	/** At most one bit per symbol in FGASInputComboState::HeldSymbols. */
+	static constexpr int32 MaxSymbols = 64;
+
+private:
+	struct FChord
+	{
+		uint64 RequiredHeld = 0;
+		int32 ComboIndex = INDEX_NONE;
+	};
+
+	/** True if the last steps of the state were pressed close enough together for the combo. */
+	static bool HasValidTiming(const FGASInputComboState& State, const FGASCompiledInputCombo& Combo);
+
+	TArray<FGASCompiledInputCombo> CompiledCombos;
+
+	TArray<const UInputAction*> Actions;
+	TMap<const UInputAction*, int32> SymbolByAction;
+
+	/** Next state for each state and symbol, NumStates * NumSymbols entries. */
+	TArray<int32> Transitions;
+
+	/** Sequence ending at each state, or INDEX_NONE. */
+	TArray<int32> StateOutputs;
+
+	/** Closest state along the fallback chain with an output, so shorter sequences ending with this one are found too. */
+	TArray<int32> OutputLinks;
+
+	/** Longest step interval of every sequence, a slower press starts over from the first state. */
+	float MaxStepInterval = 0.f;
+
+	/** Chords sorted by completing symbol, then with the most held actions first. */
+	TArray<FChord> Chords;
+
+	/** Range of each symbol in Chords, as start and end. */
+	TArray<TPair<int32, int32>> ChordRangeBySymbol;
+};
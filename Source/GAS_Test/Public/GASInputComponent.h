@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "EnhancedInputComponent.h"
+#include "InputAction.h"
 #include "GASInputConfig.h"
 #include "GASInputComponent.generated.h"
 
@@ -16,13 +17,15 @@ class GAS_TEST_API UGASInputComponent : public UEnhancedInputComponent
 	virtual void InitializeComponent() override;
 
 public:
+	/** Binds every compiled binding of the config, appending the binding handles to OutBindingHandles so they can be removed individually. */
 	template<class UserClass,  typename AbilityFuncType, typename EventFuncType, typename DynamicFuncType>
-	void BindAbilityActions(const UGASInputConfig* InputConfig, UserClass* Object, AbilityFuncType AbilityFunc, EventFuncType EventFunc, DynamicFuncType DynamicFunc);
+	void BindAbilityActions(const UGASInputConfig* InputConfig, UserClass* Object, AbilityFuncType AbilityFunc, EventFuncType EventFunc, DynamicFuncType DynamicFunc,
+		TArray<uint32>* OutBindingHandles = nullptr);
 };
 
 template <class UserClass, typename AbilityFuncType, typename EventFuncType, typename DynamicFuncType>
 void UGASInputComponent::BindAbilityActions(const UGASInputConfig* InputConfig, UserClass* Object,
-	AbilityFuncType AbilityFunc, EventFuncType EventFunc, DynamicFuncType DynamicFunc)
+	AbilityFuncType AbilityFunc, EventFuncType EventFunc, DynamicFuncType DynamicFunc, TArray<uint32>* OutBindingHandles)
 {
     check(InputConfig);
     
@@ -32,67 +35,44 @@ void UGASInputComponent::BindAbilityActions(const UGASInputConfig* InputConfig,
         return;
     }
 
-    const TMap<UInputAction*, FEventActionPairTag>& Actions = InputConfig->AbilityInputActions;
-
-    for (const TPair<UInputAction*, FEventActionPairTag>& ActionPair : Actions)
+    // The config has already flattened and validated its bindings, binding is a single pass over packed records
+    for (const FGASInputBinding& Binding : InputConfig->GetCompiledBindings())
     {
-        UInputAction* InputAction = ActionPair.Key;
-        const FEventActionPairTag& InnerMap = ActionPair.Value;
+        uint32 BindingHandle = 0;
 
-        if (!InputAction)
+        // Bind based on event type
+        switch (Binding.EventType)
         {
-            UE_LOG(LogTemp, Warning, TEXT("Skipping null InputAction!"));
-            continue;
+        case GASInputEventType::GameplayAbility:
+            BindingHandle = BindAction(Binding.InputAction, Binding.TriggerEvent, Object, AbilityFunc, Binding.InputTag, Binding.TriggerEvent).GetHandle();
+            UE_LOG(LogTemp, Log, TEXT("Bound as Ability: %s | Trigger: %s | Tag: %s"), 
+                *Binding.InputAction->GetName(), *UEnum::GetValueAsString(Binding.TriggerEvent), *Binding.InputTag.ToString());
+            break;
+
+        case GASInputEventType::GameplayEvent:
+            BindingHandle = BindAction(Binding.InputAction, Binding.TriggerEvent, Object, EventFunc, Binding.InputTag, Binding.TriggerEvent).GetHandle();
+            UE_LOG(LogTemp, Log, TEXT("Bound as Event: %s | Trigger: %s | Tag: %s"), 
+                *Binding.InputAction->GetName(), *UEnum::GetValueAsString(Binding.TriggerEvent), *Binding.InputTag.ToString());
+            break;
+            
+        case GASInputEventType::GameplayDynamic:
+            BindingHandle = BindAction(Binding.InputAction, Binding.TriggerEvent, Object, DynamicFunc, Binding.InputTag, Binding.TriggerEvent).GetHandle();
+            UE_LOG(LogTemp, Log, TEXT("Bound as Dynamic: %s | Trigger: %s | Tag: %s"), 
+                *Binding.InputAction->GetName(), *UEnum::GetValueAsString(Binding.TriggerEvent), *Binding.InputTag.ToString());
+            break;
+        	
+        case GASInputEventType::NotApplicable:
+        	UE_LOG(LogTemp, Warning, TEXT("Input event not applicable. Skipping Bind!"));
+        	break;
+
+        default:
+            UE_LOG(LogTemp, Warning, TEXT("Unknown GASInputEventType for InputAction: %s"), *Binding.InputAction->GetName());
+            break;
         }
 
-        // Ensure AbilityTriggerMappings exists inside FEventActionPairTag
-        for (const TPair<FGameplayTag, FEventActionPair>& GameplayTagPair : InnerMap.TaggedAction)
+        if (OutBindingHandles && BindingHandle != 0)
         {
-            FGameplayTag GameplayTag = GameplayTagPair.Key;
-            const FEventActionPair& EventMap = GameplayTagPair.Value;
-
-            for (const TPair<ETriggerEvent, GASInputEventType>& EventPair : EventMap.EventAction)
-            {
-                ETriggerEvent TriggerEvent = EventPair.Key;
-                GASInputEventType EventType = EventPair.Value;
-                
-                // Ensure valid mapping
-                if (!GameplayTag.IsValid())
-                {
-                    UE_LOG(LogTemp, Warning, TEXT("Skipping invalid GameplayTag for InputAction: %s"), *InputAction->GetName());
-                    continue;
-                }
-
-                // Bind based on event type
-                switch (EventType)
-                {
-                case GASInputEventType::GameplayAbility:
-                    BindAction(InputAction, TriggerEvent, Object, AbilityFunc, GameplayTag);
-                    UE_LOG(LogTemp, Log, TEXT("Bound as Ability: %s | Trigger: %s | Tag: %s"), 
-                        *InputAction->GetName(), *UEnum::GetValueAsString(TriggerEvent), *GameplayTag.ToString());
-                    break;
-
-                case GASInputEventType::GameplayEvent:
-                    BindAction(InputAction, TriggerEvent, Object, EventFunc, GameplayTag);
-                    UE_LOG(LogTemp, Log, TEXT("Bound as Event: %s | Trigger: %s | Tag: %s"), 
-                        *InputAction->GetName(), *UEnum::GetValueAsString(TriggerEvent), *GameplayTag.ToString());
-                    break;
-                    
-                case GASInputEventType::GameplayDynamic:
-                    BindAction(InputAction, TriggerEvent, Object, DynamicFunc, GameplayTag);
-                    UE_LOG(LogTemp, Log, TEXT("Bound as Dynamic: %s | Trigger: %s | Tag: %s"), 
-                        *InputAction->GetName(), *UEnum::GetValueAsString(TriggerEvent), *GameplayTag.ToString());
-                    break;
-                	
-                case GASInputEventType::NotApplicable:
-                	UE_LOG(LogTemp, Warning, TEXT("Input event not applicable. Skipping Bind!"));
-                	break;
-
-                default:
-                    UE_LOG(LogTemp, Warning, TEXT("Unknown GASInputEventType for InputAction: %s"), *InputAction->GetName());
-                    break;
-                }
-            }
+            OutBindingHandles->Add(BindingHandle);
         }
     }
 }
@@ -6,8 +6,11 @@
 #include "EnhancedInputSubsystemInterface.h"
 #include "Engine/DataAsset.h"
 #include "GameplayTagContainer.h"
+#include "GASInputCombo.h"
 #include "GASInputConfig.generated.h"
 
+class UInputAction;
+
 UENUM(BlueprintType) 
 enum class GASInputEventType : uint8
 {
@@ -18,13 +21,58 @@ enum class GASInputEventType : uint8
 };
 
 
+/**
+ * How a tag is dispatched on each trigger event of its input action, NotApplicable where it isn't bound.
+ * One byte per trigger event rather than a map holding at most five entries.
+ */
 USTRUCT(BlueprintType)
-struct FEventActionPair
+struct GAS_TEST_API FEventActionPair
 {
 	GENERATED_BODY()
 
 	UPROPERTY(EditDefaultsOnly)
-	TMap<ETriggerEvent,GASInputEventType> EventAction;
+	GASInputEventType Triggered = GASInputEventType::NotApplicable;
+
+	UPROPERTY(EditDefaultsOnly)
+	GASInputEventType Started = GASInputEventType::NotApplicable;
+
+	UPROPERTY(EditDefaultsOnly)
+	GASInputEventType Ongoing = GASInputEventType::NotApplicable;
+
+	UPROPERTY(EditDefaultsOnly)
+	GASInputEventType Canceled = GASInputEventType::NotApplicable;
+
+	UPROPERTY(EditDefaultsOnly)
+	GASInputEventType Completed = GASInputEventType::NotApplicable;
+
+#if WITH_EDITORONLY_DATA
+	/** Replaced by the per trigger event fields, moved into them on load */
+	UPROPERTY(meta = (DeprecatedProperty, DeprecationMessage = "Use the per trigger event fields."))
+	TMap<ETriggerEvent,GASInputEventType> EventAction_DEPRECATED;
+#endif
+
+	/** Dispatch type of a trigger event, NotApplicable if unbound or not a single trigger event. */
+	GASInputEventType GetEventType(ETriggerEvent TriggerEvent) const;
+	void SetEventType(ETriggerEvent TriggerEvent, GASInputEventType EventType);
+
+	/** Calls Func(ETriggerEvent, GASInputEventType) for every bound trigger event, in the order of ETriggerEvent. */
+	template<typename FuncType>
+	void ForEachEventType(FuncType Func) const
+	{
+		for (const ETriggerEvent TriggerEvent : { ETriggerEvent::Triggered, ETriggerEvent::Started, ETriggerEvent::Ongoing, ETriggerEvent::Canceled, ETriggerEvent::Completed })
+		{
+			const GASInputEventType EventType = GetEventType(TriggerEvent);
+			if (EventType != GASInputEventType::NotApplicable)
+			{
+				Func(TriggerEvent, EventType);
+			}
+		}
+	}
+
+#if WITH_EDITORONLY_DATA
+	/** Moves the entries of EventAction_DEPRECATED into the fields. Returns true if there were any. */
+	bool UpgradeEventAction();
+#endif
 };
 
 USTRUCT(BlueprintType)
@@ -49,6 +97,65 @@ struct FICMPayload
 };
 
 
+UENUM(BlueprintType)
+enum class EGASInputComboType : uint8
+{
+	/** Actions pressed one after the other, each within MaxStepInterval of the previous one. */
+	Sequence,
+
+	/** Every action but the last held, then the last one pressed. */
+	Chord
+};
+
+/**
+ * A chord or sequence of input actions sending one tag when completed, e.g. "A then B within 300 ms" or "hold X and press Y".
+ */
+USTRUCT(BlueprintType)
+struct FGASInputCombo
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditDefaultsOnly)
+	EGASInputComboType Type = EGASInputComboType::Sequence;
+
+	/** Steps of a sequence in order, or the held actions of a chord followed by the action completing it. At least two */
+	UPROPERTY(EditDefaultsOnly)
+	TArray<TObjectPtr<const UInputAction>> Actions;
+
+	/** Longest time between two steps of a sequence, in seconds */
+	UPROPERTY(EditDefaultsOnly, Meta = (ClampMin = "0.0", Units = "s", EditCondition = "Type == EGASInputComboType::Sequence"))
+	float MaxStepInterval = 0.3f;
+
+	/** Tag sent when the combo completes */
+	UPROPERTY(EditDefaultsOnly)
+	FGameplayTag InputTag;
+
+	/** How the tag is dispatched, as for a binding of AbilityInputActions */
+	UPROPERTY(EditDefaultsOnly)
+	GASInputEventType EventType = GASInputEventType::GameplayAbility;
+};
+
+/**
+ * One record of the compiled binding table: an input action, the trigger event it is bound on,
+ * the tag it sends and how that tag is dispatched to GAS.
+ */
+struct FGASInputBinding
+{
+	const UInputAction* InputAction = nullptr;
+	ETriggerEvent TriggerEvent = ETriggerEvent::None;
+	GASInputEventType EventType = GASInputEventType::NotApplicable;
+	FGameplayTag InputTag;
+};
+
+/**
+ * A contiguous range of the compiled binding table, or of its tag index.
+ */
+struct FGASInputBindingRange
+{
+	int32 Start = 0;
+	int32 Num = 0;
+};
+
 UCLASS()
 class GAS_TEST_API UGASInputConfig : public UDataAsset
 {
@@ -60,4 +167,68 @@ public:
 
 	UPROPERTY(EditDefaultsOnly)
 	TMap<class UInputMappingContext*, FICMPayload> DefaultInputMapping;
+
+	/**
+	 * Chords and sequences of the input actions, each sending one tag when completed. The actions don't need a binding
+	 * in AbilityInputActions, but their mapping contexts must be added for them to fire.
+	 */
+	UPROPERTY(EditDefaultsOnly)
+	TArray<FGASInputCombo> Combos;
+
+	/**
+	 * Clear when every Ability Input Handler using this config runs server lean, so the config, its input actions and mapping
+	 * contexts are left out of dedicated servers. Handlers referencing it then see a null config on the server.
+	 */
+	UPROPERTY(EditDefaultsOnly, AdvancedDisplay)
+	bool bLoadOnDedicatedServer = true;
+
+	virtual void PostLoad() override;
+	virtual bool NeedsLoadForServer() const override;
+	virtual void GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize) override;
+
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
+	/**
+	 * Every valid binding of AbilityInputActions as a flat array, sorted by input action name, then tag, then trigger event,
+	 * so indices are the same in every session. Invalid tags and null actions are left out. Compiled on load, or on first use.
+	 */
+	const TArray<FGASInputBinding>& GetCompiledBindings() const;
+
+	/** Hash of the compiled binding table and the combos, the same across sessions and machines for the same bindings. */
+	uint32 GetCompiledBindingsHash() const;
+
+	/** Returns the compiled bindings of an input action, contiguous in the binding table. */
+	TArrayView<const FGASInputBinding> FindBindingsForAction(const UInputAction* InputAction) const;
+
+	/** Returns the indices, in the compiled binding table, of every binding sending exactly this tag. */
+	TArrayView<const int32> FindBindingIndicesForTag(const FGameplayTag& InputTag) const;
+
+	/** Combos compiled into one matcher, compiled with the bindings. */
+	const FGASInputComboMatcher& GetComboMatcher() const;
+
+private:
+	/** Flattens AbilityInputActions into the binding table and builds its indices, then compiles the combos. */
+	void CompileBindings() const;
+
+	/** Compiled binding table, see GetCompiledBindings. */
+	mutable TArray<FGASInputBinding> CompiledBindings;
+
+	/** See GetCompiledBindingsHash. */
+	mutable uint32 CompiledBindingsHash = 0;
+
+	/** Range of each input action in the binding table. */
+	mutable TMap<const UInputAction*, FGASInputBindingRange> BindingRangeByAction;
+
+	/** Binding table indices sorted by tag, so the bindings of one tag are contiguous. */
+	mutable TArray<int32> BindingIndicesSortedByTag;
+
+	/** Range of each tag in BindingIndicesSortedByTag. */
+	mutable TMap<FGameplayTag, FGASInputBindingRange> BindingRangeByTag;
+
+	/** See GetComboMatcher. */
+	mutable FGASInputComboMatcher ComboMatcher;
+
+	mutable bool bBindingsCompiled = false;
 };
@@ -0,0 +1,13 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+
+/**
+ * Stat groups shared by the GAS_Test module.
+ * Individual stats are declared in the translation units that update them.
+ * 
+ * Use 'stat AbilityStateTags' or 'stat AbilityInput' in the console to display them.
+ */
+DECLARE_STATS_GROUP(TEXT("Ability State Tags"), STATGROUP_AbilityStateTags, STATCAT_Advanced);
+DECLARE_STATS_GROUP(TEXT("Ability Input"), STATGROUP_AbilityInput, STATCAT_Advanced);
@@ -5,6 +5,7 @@
 #include "GameplayAbility_BaseTriggeredInputActionAbility.generated.h"
 
 struct FInputActionValue;
+class UAbilityInputHandler;
 
 /*
 Original code by Urszula "Ula" Kustra
@@ -19,11 +20,14 @@ class GAS_TEST_API UGameplayAbility_BaseTriggeredInputActionAbility : public UGa
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Ability")
 	bool bCancelAbilityOnInputReleased;
 
+	friend UAbilityInputHandler;
+
 protected:
-	UPROPERTY()
-	TObjectPtr<UEnhancedInputComponent> EnhancedInputComponent;
+	/** Handler of the avatar, found on the first activation and reused until the avatar changes. */
+	TWeakObjectPtr<UAbilityInputHandler> AbilityInputHandler;
 
-	TArray<uint32> TriggeredEventHandles;
+	/** Returns the avatar's input handler, only looking it up when the avatar has changed. */
+	UAbilityInputHandler* FindAbilityInputHandler(const APawn* Avatar);
 	
 	virtual void ActivateAbility(const FGameplayAbilitySpecHandle Handle, const FGameplayAbilityActorInfo* ActorInfo, const FGameplayAbilityActivationInfo ActivationInfo, const FGameplayEventData* TriggerEventData) override;
 	virtual void EndAbility(const FGameplayAbilitySpecHandle Handle, const FGameplayAbilityActorInfo* ActorInfo, const FGameplayAbilityActivationInfo ActivationInfo, bool bReplicateEndAbility, bool bWasCancelled) override;